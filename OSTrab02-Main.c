@@ -205,6 +205,9 @@ char data[block_size - sizeof(uint32_t)];
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <io.h>
 #include <Windows.h>
 
 #define DISK_SIZE (1ULL * 1024 * 1024 * 1024) // 1 GB
@@ -214,11 +217,34 @@ char data[block_size - sizeof(uint32_t)];
 #define MAX_FILES 1000
 #define BLOCK_SIZE 4096       // Tamanho de um bloco (4 KB)
 #define NUM_BLOCKS (DISK_SIZE / BLOCK_SIZE) // Nmero total de blocos
+#define NUM_BLOCOS_DADOS ((DISK_SIZE - META_DATA_SIZE - 1) / BLOCK_SIZE) // Blocos antes dos metadados (alocveis)
+#define CACHE_PAGE_SIZE 4096 // Tamanho de uma pgina do cache de blocos
+#define CACHE_TAMANHO_PADRAO (8 * 1024 * 1024) // Memria padro do cache de blocos (8 MB)
+#define CACHE_READAHEAD 8 // Pginas lidas de uma vez quando o acesso  sequencial
+#define CACHE_LEITURA_DIRETA (256 * 1024) // Leituras a partir deste tamanho no passam pelo cache
+#define ORCAMENTO_FRACAO_MEMORIA 4 // Oramento automtico: 1/4 da memria fsica disponvel
+#define ORCAMENTO_MAXIMO DISK_SIZE // Nenhum arquivo passa do tamanho do disco
+#define IO_DIRETO_MAX_TRANSFERENCIA (64 * 1024 * 1024) // Maior transferncia direta por chamada
+#define TRANSFERENCIA_HOST (16 * 1024 * 1024) // Buffer das cpias entre o host e o disco virtual
+#define LOTE_MAX_TRABALHADORES 8 // Ordenaes simultneas de 'ordenar_lote'
+#define PONTO_DE_CONTROLE_ASSINATURA 0x4F524443 // Marca um ponto de controle gravado por esta verso
+#define METADADOS_ASSINATURA 0x4F534D44 // Marca a extenso dos metadados (campos posteriores  verso original)
+#define METADADOS_VERSAO 1
+#define CAMINHO_SIMULACAO "simulacao.bin" // Imagem de rascunho do simulador
+#define ARQUIVO_NULO "NUL" // Destino da sada das operaes durante a simulao
+#define SIMULACAO_OCUPACAO_ALVO 0.85 // Acima desta ocupao o gerador apaga mais do que cria
+#define BITMAP_DISTINTOS_BYTES (32 * 1024 * 1024) // Bitmap de valores para 'distintos' (2^28 valores)
+#define HASH_DISTINTOS_CAPACIDADE (1 << 22) // Posies do conjunto hash de 'distintos' (potncia de 2)
+#define DISTINTOS_PARTICOES 16 // Parties do transbordo de 'distintos': 2^32 chaves / 2^28 bits do bitmap
+#define DISTINTOS_PEDACO (64 * 1024) // Chaves por pedao de partio gravado no pagefile (256 KB)
+#define TRECHO_PEQUENO_FRACAO 16 // 'ordenar_adaptativo' s agrupa trechos menores que 1/16 do oramento
 
 typedef struct {
     char nome[MAX_FILENAME_LENGTH];
     size_t tamanho;
     size_t posicao;
+    int ordenado; // 1 se o contedo j est em ordem crescente
+    int tipo;     // TIPO_*
 } Arquivo;
 
 typedef struct {
@@ -226,28 +252,282 @@ typedef struct {
     Arquivo arquivos[MAX_FILES];
     size_t quantidade_arquivos;
     size_t espaco_livre;
+    unsigned short referencias[NUM_BLOCKS]; // Arquivos que compartilham cada bloco (clonar)
 } SistemaDeArquivos;
 
+// Entrada do catlogo como  gravada no disco: o registro da verso original (272 bytes)
+typedef struct {
+    char nome[MAX_FILENAME_LENGTH];
+    size_t tamanho;
+    size_t posicao;
+} RegistroArquivo;
+
+// Campos de Arquivo acrescentados depois da verso original
+typedef struct {
+    int ordenado;
+    int tipo;
+} AtributosArquivo;
+
+// Metadados como so gravados no disco. Os campos da verso original ficam nas mesmas posies e o resto
+// vem depois deles; discos antigos terminam antes da extenso, que ento recebe os valores padro
+typedef struct {
+    unsigned char bitmap[NUM_BLOCKS / 8];
+    RegistroArquivo arquivos[MAX_FILES];
+    size_t quantidade_arquivos;
+    size_t espaco_livre;
+    unsigned int assinatura;    // METADADOS_ASSINATURA se a extenso abaixo foi gravada
+    unsigned int versao;        // METADADOS_VERSAO de quem gravou
+    AtributosArquivo atributos[MAX_FILES];
+    unsigned short referencias[NUM_BLOCKS];
+} MetadadosDisco;
+
 // typedef struct {
 //     Arquivo arquivos[MAX_FILES];
 //     size_t quantidade_arquivos;
 //     size_t espaco_livre;
 // } SistemaDeArquivos;
 
+enum { TIPO_INT32, TIPO_INT64, TIPO_UINT32, TIPO_FLOAT, TIPO_DOUBLE, TIPO_CHAVE_VALOR, NUM_TIPOS };
+
+// Registro de tamanho fixo ordenado pela chave
+typedef struct {
+    long long chave;
+    long long valor;
+} RegistroChaveValor;
+
+// Operaes de um tipo de elemento, geradas por DEFINIR_KERNELS
+typedef struct {
+    const char* nome;
+    size_t tamanho; // Bytes por elemento
+    void (*ordenar)(void* dados, size_t n);
+    void (*intercalar)(const void* a, size_t na, size_t* ia, const void* b, size_t nb, size_t* ib,
+        void* saida, size_t ns, size_t* is);
+    int (*em_ordem)(const void* dados, size_t n);
+    void (*selecionar)(const void* dados, size_t n, void* heap, size_t* tamanho_heap, size_t limite, int maiores);
+    void (*esvaziar_heap)(void* heap, size_t n, int maiores);
+    void (*imprimir)(const void* dados, size_t n);
+    void (*gerar)(void* dados, size_t n);
+} OperacoesTipo;
+
+enum { TRECHO_CRESCENTE, TRECHO_DECRESCENTE, TRECHO_MISTO };
+
+enum { POLITICA_PRIMEIRO, POLITICA_MELHOR, POLITICA_PROXIMO };
+
+enum { SIM_CRIAR, SIM_APAGAR, SIM_CONCATENAR, SIM_ORDENAR, SIM_NUM_OPERACOES };
+
+// Distribuio dos tamanhos dos arquivos criados pelo simulador
+typedef struct {
+    size_t tamanho_min;     // Bytes
+    size_t tamanho_max;
+    int logaritmica;        // 1: log-uniforme (muitos arquivos pequenos, poucos grandes); 0: uniforme
+} ConfiguracaoSimulacao;
+
+// Espao livre da rea de dados, medido no bitmap
+typedef struct {
+    size_t blocos_livres;
+    size_t maior_extensao;  // Em blocos
+    size_t extensoes_livres;
+} EstadoEspaco;
+
+// Trecho (run) natural encontrado pela ordenao adaptativa, em inteiros a partir do incio do arquivo
+typedef struct {
+    size_t inicio;
+    size_t tamanho;
+    int estado;         // TRECHO_MISTO: trechos pequenos agrupados, ainda fora de ordem
+} Trecho;
+
+// Valores distintos juntados por coletar_distintos, como chaves uint32 na ordem do tipo
+typedef struct {
+    unsigned int* chaves;           // Conjunto hash (endereamento aberto); no fim, as chaves juntas no incio
+    unsigned char* ocupado;
+    size_t quantidade;
+    unsigned int menor;             // Faixa das chaves
+    unsigned int maior;
+    size_t vizinhos;                // 1 + trocas entre vizinhos: a contagem, se o arquivo estiver ordenado
+    int transbordou;                // 1: o conjunto encheu e as chaves foram para as parties do pagefile
+    char pagefile[MAX_FILENAME_LENGTH + 1];
+    size_t pagefile_pos;
+    unsigned int* particoes;        // Um pedao em memria por partio, gravado quando enche
+    size_t na_particao[DISTINTOS_PARTICOES];
+    unsigned int* pedacos_usados;   // Chaves em cada pedao gravado
+    unsigned char* pedacos_particao; // Partio dona de cada pedao
+    size_t num_pedacos;
+} ColetaDistintos;
+
+enum { FILA_NENHUMA, FILA_A1IN, FILA_AM, FILA_A1OUT };
+
+typedef struct {
+    size_t pagina;      // Nmero da pgina no disco virtual
+    int fila;           // Fila 2Q em que o descritor est
+    int anterior;       // Encadeamento na fila
+    int proximo;
+    int proximo_hash;   // Prximo no balde do hash (ou na lista de livres)
+    int quadro;         // Quadro de dados; -1 para fantasmas de A1out
+} DescritorCache;
+
+typedef struct {
+    int cabeca;         // Mais recente
+    int cauda;          // Mais antigo
+    size_t tamanho;
+} FilaCache;
+
+typedef struct {
+    unsigned char* dados;        // num_quadros pginas
+    DescritorCache* descritores;
+    int* baldes;
+    size_t num_baldes;
+    int* quadros_livres;
+    size_t num_quadros_livres;
+    int descritores_livres;
+    size_t num_quadros;
+    size_t kin;                  // Tamanho alvo de A1in
+    size_t kout;                 // Mximo de fantasmas em A1out
+    size_t readahead;
+    unsigned char* leitura;      // Buffer da leitura antecipada
+    size_t ultima_pagina;
+    FilaCache a1in, am, a1out;
+    size_t acertos, faltas, antecipadas, leituras_diretas;
+} CacheBlocos;
+
+enum { FASE_RUNS, FASE_MESCLAGEM, FASE_CONCLUIDA };
+
+// Uma ordenao de 'ordenar_lote', dividida em passos: os segmentos da gerao de runs e os pares de cada
+// passada de mesclagem. Guarda posies absolutas, porque o catlogo pode ser compactado durante o lote
+typedef struct {
+    char nome[MAX_FILENAME_LENGTH];
+    char pagefile[MAX_FILENAME_LENGTH]; // Vazio se o arquivo cabe em um segmento
+    size_t posicao;
+    size_t tamanho;     // Bytes
+    int tipo;
+    size_t pagefile_pos;
+    size_t num_elementos;
+    size_t segmento;            // Elementos por run
+    size_t paginas_segmento;    // Pginas da arena usadas por um passo da gerao de runs
+    int fase;                   // FASE_RUNS, FASE_MESCLAGEM ou FASE_CONCLUIDA
+    size_t run_size;            // Runs da passada de mesclagem atual
+    size_t proximo;             // Prximo segmento (ou par da passada) a despachar
+    size_t num_passos;          // Segmentos, ou pares da passada atual
+    int em_andamento;           // Passos despachados e ainda no terminados
+    clock_t inicio;
+} TarefaOrdenacao;
+
+// Um passo entregue a um trabalhador, com a memria emprestada da arena
+typedef struct {
+    int tarefa;
+    int fase;
+    size_t indice;              // Segmento ou par
+    size_t run_size;
+    size_t primeira_pagina;
+    size_t paginas;
+} PassoLote;
+
+// Estado do lote, protegido por 'trava'. O oramento global  uma arena de pginas de LARGE_PAGE_SIZE
+typedef struct {
+    TarefaOrdenacao* tarefas;
+    int num_tarefas;
+    int concluidas;
+    int ociosos;                // Trabalhadores sem passo
+    char* arena;
+    unsigned char* paginas_ocupadas;
+    size_t num_paginas;
+    size_t paginas_livres;
+    CRITICAL_SECTION trava;
+    CONDITION_VARIABLE mudou;   // Sinalizada quando um passo termina (memria livre, passada nova ou fim do lote)
+} FilaLote;
+
+// Progresso de uma ordenao externa de 'ordenar', gravado logo aps os metadados a cada passo concludo.
+// Um passo  um segmento da gerao de runs ou um par da mesclagem
+typedef struct {
+    unsigned int assinatura;
+    int ativo;                  // 1 enquanto a ordenao no termina
+    char nome[MAX_FILENAME_LENGTH];
+    int tipo;
+    size_t posicao;             // Extenso do arquivo e do pagefile no incio da ordenao
+    size_t num_elementos;
+    size_t pagefile_pos;
+    size_t orcamento;           // Define os limites dos runs, ento a continuao usa o mesmo
+    int fase;                   // FASE_RUNS ou FASE_MESCLAGEM
+    size_t proximo;             // Prximo segmento (runs) ou prximo par (mesclagem)
+    size_t run_size;            // Tamanho dos runs da passada de mesclagem atual
+    size_t feitos;              // Elementos processados, somando todas as passadas (progresso)
+    size_t total;
+    int copia_pendente;         // Passo j escrito no pagefile, falta copiar para o arquivo
+    size_t copia_origem;
+    size_t copia_destino;
+    size_t copia_bytes;
+} PontoDeControle;
+
 SistemaDeArquivos sa;
+MetadadosDisco metadados_disco; // 'sa' no formato do disco (salvar_estado e iniciar_sistema_arquivos)
 FILE* disco_virtual;
 void* huge_page = NULL;
+CacheBlocos cache;
+HANDLE disco_direto = INVALID_HANDLE_VALUE;
+int modo_io_direto = 1; // Grandes transferncias usam o handle sem cache do sistema
+size_t orcamento_ordenacao_padrao = 0; // Memria das ordenaes; 0 = automtico
+PontoDeControle ponto_de_controle; // Ordenao externa em andamento (ou interrompida)
+size_t interromper_apos_passos = 0; // Para testes: encerra o processo aps tantos passos de ordenao; 0 = nunca
+const char* caminho_disco = "disco_virtual.bin"; // Trocado pelo simulador enquanto ele roda
+int politica_alocacao = POLITICA_PRIMEIRO;
+size_t proximo_bloco_busca = 0; // Onde a poltica 'proximo' retoma a busca
+LONGLONG ticks_alocacao = 0; // Tempo acumulado em encontrar_bloco_livre (QueryPerformanceCounter)
+const char* nomes_politicas[] = { "primeiro", "melhor", "proximo" };
+const char* nomes_operacoes_simulacao[SIM_NUM_OPERACOES] = { "criar", "apagar", "concatenar", "ordenar" };
+ConfiguracaoSimulacao config_simulacao = { 4 * 1024, 4 * 1024 * 1024, 1 };
+CRITICAL_SECTION trava_disco; // Protege o stdio do disco e o cache quando h vrias threads (ordenar_lote)
+
+// Monta 'sa' a partir dos metadados lidos do disco. Sem a assinatura (disco da verso original), cada arquivo
+//  int32 fora de ordem e cada bloco ocupado pertence a um s arquivo
+void carregar_metadados(const MetadadosDisco* metadados) {
+    int extensao = metadados->assinatura == METADADOS_ASSINATURA;
+
+    memcpy(sa.bitmap, metadados->bitmap, sizeof(sa.bitmap));
+    sa.quantidade_arquivos = metadados->quantidade_arquivos;
+    sa.espaco_livre = metadados->espaco_livre;
+
+    for (size_t i = 0; i < MAX_FILES; i++) {
+        memcpy(sa.arquivos[i].nome, metadados->arquivos[i].nome, MAX_FILENAME_LENGTH);
+        sa.arquivos[i].tamanho = metadados->arquivos[i].tamanho;
+        sa.arquivos[i].posicao = metadados->arquivos[i].posicao;
+        sa.arquivos[i].ordenado = extensao ? metadados->atributos[i].ordenado : 0;
+        sa.arquivos[i].tipo = extensao && metadados->atributos[i].tipo < NUM_TIPOS ? metadados->atributos[i].tipo : TIPO_INT32;
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++) {
+        int ocupado = (sa.bitmap[i / 8] & (1 << (i % 8))) != 0;
+        sa.referencias[i] = extensao ? metadados->referencias[i] : 0;
+        if (ocupado && sa.referencias[i] == 0) sa.referencias[i] = 1;
+    }
+}
+
+void gravar_metadados(MetadadosDisco* metadados) {
+    memcpy(metadados->bitmap, sa.bitmap, sizeof(sa.bitmap));
+    metadados->quantidade_arquivos = sa.quantidade_arquivos;
+    metadados->espaco_livre = sa.espaco_livre;
+    metadados->assinatura = METADADOS_ASSINATURA;
+    metadados->versao = METADADOS_VERSAO;
+
+    for (size_t i = 0; i < MAX_FILES; i++) {
+        memcpy(metadados->arquivos[i].nome, sa.arquivos[i].nome, MAX_FILENAME_LENGTH);
+        metadados->arquivos[i].tamanho = sa.arquivos[i].tamanho;
+        metadados->arquivos[i].posicao = sa.arquivos[i].posicao;
+        metadados->atributos[i].ordenado = sa.arquivos[i].ordenado;
+        metadados->atributos[i].tipo = sa.arquivos[i].tipo;
+    }
+
+    memcpy(metadados->referencias, sa.referencias, sizeof(sa.referencias));
+}
 
 // Inicializao
 void iniciar_sistema_arquivos() {
     printf("Iniciando sistema de arquivos\n");
-    disco_virtual = fopen("disco_virtual.bin", "r+b");
+    disco_virtual = fopen(caminho_disco, "r+b");
     if (!disco_virtual) {
-        disco_virtual = fopen("disco_virtual.bin", "w+b");
+        disco_virtual = fopen(caminho_disco, "w+b");
         fseek(disco_virtual, DISK_SIZE - META_DATA_SIZE - 1, SEEK_SET); // Define tamanho do arquivo
         fputc('\0', disco_virtual); // Escreve um byte nulo no final
         fclose(disco_virtual); // Fecha o arquivo
-        disco_virtual = fopen("disco_virtual.bin", "r+b"); // Reabre o arquivo
+        disco_virtual = fopen(caminho_disco, "r+b"); // Reabre o arquivo
 
         sa.quantidade_arquivos = 0;
         sa.espaco_livre = DISK_SIZE - META_DATA_SIZE;
@@ -256,7 +536,15 @@ void iniciar_sistema_arquivos() {
     else {
         // Carregar estado salvo
         fseek(disco_virtual, DISK_SIZE - META_DATA_SIZE - 1, SEEK_SET);
-        fread(&sa, sizeof(SistemaDeArquivos), 1, disco_virtual);
+        memset(&metadados_disco, 0, sizeof(MetadadosDisco));
+        fread(&metadados_disco, sizeof(MetadadosDisco), 1, disco_virtual);
+        carregar_metadados(&metadados_disco);
+
+        // O ponto de controle vem logo depois; discos antigos tm zeros (ou dados) a, sem a assinatura
+        fread(&ponto_de_controle, sizeof(PontoDeControle), 1, disco_virtual);
+        if (ponto_de_controle.assinatura != PONTO_DE_CONTROLE_ASSINATURA) {
+            memset(&ponto_de_controle, 0, sizeof(PontoDeControle));
+        }
     }
     printf("Sistema de arquivos inicializado\n");
 }
@@ -272,47 +560,513 @@ void marcar_bloco_ocupado(size_t bloco) {
     size_t byte_index = bloco / 8;
     size_t bit_index = bloco % 8;
     sa.bitmap[byte_index] |= (1 << bit_index); // Define o bit como 1 (ocupado)
+    sa.referencias[bloco] = 1;
 }
 
 void marcar_bloco_livre(size_t bloco) {
     size_t byte_index = bloco / 8;
     size_t bit_index = bloco % 8;
     sa.bitmap[byte_index] &= ~(1 << bit_index); // Define o bit como 0 (livre)
+    sa.referencias[bloco] = 0;
+}
+
+// Procura, a partir do bloco 'de', uma extenso livre de 'blocos_necessarios' blocos na rea de dados.
+// Sem 'melhor', devolve a primeira que couber; com, a menor que couber (ou -1)
+size_t procurar_extensao(size_t de, size_t blocos_necessarios, int melhor) {
+    size_t melhor_inicio = -1;
+    size_t melhor_tamanho = (size_t)-1;
+    size_t i = de;
+
+    while (i < NUM_BLOCOS_DADOS) {
+        if (!bloco_esta_livre(i)) {
+            i++;
+            continue;
+        }
+
+        size_t inicio = i;
+        while (i < NUM_BLOCOS_DADOS && bloco_esta_livre(i)) {
+            i++;
+            if (!melhor && i - inicio == blocos_necessarios) return inicio;
+        }
+
+        size_t tamanho = i - inicio;
+        if (melhor && tamanho >= blocos_necessarios && tamanho < melhor_tamanho) {
+            melhor_inicio = inicio;
+            melhor_tamanho = tamanho;
+            if (tamanho == blocos_necessarios) break; // Encaixe exato: no h melhor
+        }
+    }
+
+    return melhor_inicio;
 }
 
+// Reserva uma extenso contgua para 'tamanho' bytes segundo a poltica de alocao (padro: primeiro-apto).
+// S a rea antes dos metadados  alocvel
 size_t encontrar_bloco_livre(size_t tamanho) {
+    LARGE_INTEGER antes, depois;
+    QueryPerformanceCounter(&antes);
+
     size_t blocos_necessarios = tamanho / BLOCK_SIZE + (tamanho % BLOCK_SIZE != 0);
-    size_t contador = 0;
     size_t inicio = -1;
 
-    for (size_t i = 0; i < NUM_BLOCKS; i++) {
-        if (bloco_esta_livre(i)) {
-            if (contador == 0) inicio = i; // Primeiro bloco encontrado
-            contador++;
+    if (blocos_necessarios > 0) {
+        if (politica_alocacao == POLITICA_MELHOR) {
+            inicio = procurar_extensao(0, blocos_necessarios, 1);
+        }
+        else if (politica_alocacao == POLITICA_PROXIMO) {
+            // Prximo-apto: continua de onde a ltima alocao terminou e d a volta no disco
+            inicio = procurar_extensao(proximo_bloco_busca, blocos_necessarios, 0);
+            if (inicio == -1) inicio = procurar_extensao(0, blocos_necessarios, 0);
+        }
+        else {
+            inicio = procurar_extensao(0, blocos_necessarios, 0);
+        }
+    }
 
-            if (contador == blocos_necessarios) { // Achou espao suficiente
-                for (size_t j = inicio; j < inicio + blocos_necessarios; j++) {
-                    marcar_bloco_ocupado(j); // Reservar os blocos
-                }
-                return inicio * BLOCK_SIZE; // Retorna a posio no disco
-            }
+    if (inicio != -1) {
+        for (size_t j = inicio; j < inicio + blocos_necessarios; j++) {
+            marcar_bloco_ocupado(j); // Reservar os blocos
+        }
+        proximo_bloco_busca = inicio + blocos_necessarios;
+    }
+
+    QueryPerformanceCounter(&depois);
+    ticks_alocacao += depois.QuadPart - antes.QuadPart;
+
+    return inicio == -1 ? (size_t)-1 : inicio * BLOCK_SIZE; // Posio no disco, ou -1 se no h espao
+}
+
+// Solta uma referncia aos blocos da extenso; blocos sem outras referncias voltam a ficar livres.
+// Retorna quantos bytes foram de fato liberados. Clones dividem sempre a extenso inteira (nenhum arquivo
+// compartilhado  modificado no lugar), ento os blocos so liberados todos ou nenhum
+size_t liberar_blocos(size_t posicao, size_t tamanho) {
+    size_t bloco_inicial = posicao / BLOCK_SIZE;
+    size_t num_blocos = tamanho / BLOCK_SIZE + (tamanho % BLOCK_SIZE != 0);
+    size_t liberados = 0;
+
+    for (size_t i = 0; i < num_blocos; i++) {
+        if (sa.referencias[bloco_inicial + i] > 1) {
+            sa.referencias[bloco_inicial + i]--;
         }
         else {
-            contador = 0;
-            inicio = -1;
+            marcar_bloco_livre(bloco_inicial + i);
+            liberados++;
         }
     }
 
-    return -1; // Nenhum espao suficiente encontrado
+    return liberados == num_blocos ? tamanho : liberados * BLOCK_SIZE;
+}
+
+// 1 se algum bloco da extenso tambm pertence a outro arquivo
+int extensao_compartilhada(size_t posicao, size_t tamanho) {
+    size_t bloco_inicial = posicao / BLOCK_SIZE;
+    size_t num_blocos = tamanho / BLOCK_SIZE + (tamanho % BLOCK_SIZE != 0);
+
+    for (size_t i = 0; i < num_blocos; i++) {
+        if (sa.referencias[bloco_inicial + i] > 1) return 1;
+    }
+    return 0;
 }
 
 void salvar_estado() {
+    gravar_metadados(&metadados_disco);
     fseek(disco_virtual, DISK_SIZE - META_DATA_SIZE - 1, SEEK_SET);
-    fwrite(&sa, sizeof(SistemaDeArquivos), 1, disco_virtual);
+    fwrite(&metadados_disco, sizeof(MetadadosDisco), 1, disco_virtual);
     fflush(disco_virtual);
     _commit(_fileno(disco_virtual)); // Garante que os dados so persistidos no disco
 }
 
+// Grava o ponto de controle logo aps os metadados. Os dados do passo vo para o disco antes do registro
+// que os declara prontos, para que uma queda nunca deixe o registro  frente dos dados
+void salvar_ponto_de_controle() {
+    fflush(disco_virtual);
+    _commit(_fileno(disco_virtual));
+
+    ponto_de_controle.assinatura = PONTO_DE_CONTROLE_ASSINATURA;
+    fseek(disco_virtual, DISK_SIZE - META_DATA_SIZE - 1 + sizeof(MetadadosDisco), SEEK_SET);
+    fwrite(&ponto_de_controle, sizeof(PontoDeControle), 1, disco_virtual);
+    fflush(disco_virtual);
+    _commit(_fileno(disco_virtual));
+}
+
+void descartar_ponto_de_controle() {
+    if (!ponto_de_controle.ativo) return;
+    ponto_de_controle.ativo = 0;
+    salvar_ponto_de_controle();
+}
+
+// Cache de blocos
+// Pginas de CACHE_PAGE_SIZE bytes do disco virtual mantidas em memria com a poltica 2Q:
+// - A1in: FIFO das pginas vistas uma nica vez (varreduras longas passam por aqui sem poluir Am)
+// - Am:   LRU das pginas acessadas de novo enquanto lembradas
+// - A1out: "fantasmas" (s o nmero da pgina) das pginas expulsas de A1in
+// Escritas so write-through: vo para o disco e atualizam as pginas presentes no cache.
+
+int fila_cache_remover(FilaCache* fila, int d) {
+    DescritorCache* desc = &cache.descritores[d];
+    if (desc->anterior != -1) cache.descritores[desc->anterior].proximo = desc->proximo;
+    else fila->cabeca = desc->proximo;
+    if (desc->proximo != -1) cache.descritores[desc->proximo].anterior = desc->anterior;
+    else fila->cauda = desc->anterior;
+    fila->tamanho--;
+    return d;
+}
+
+void fila_cache_inserir(FilaCache* fila, int d, int id_fila) {
+    DescritorCache* desc = &cache.descritores[d];
+    desc->fila = id_fila;
+    desc->anterior = -1;
+    desc->proximo = fila->cabeca;
+    if (fila->cabeca != -1) cache.descritores[fila->cabeca].anterior = d;
+    fila->cabeca = d;
+    if (fila->cauda == -1) fila->cauda = d;
+    fila->tamanho++;
+}
+
+FilaCache* fila_cache(int id_fila) {
+    if (id_fila == FILA_A1IN) return &cache.a1in;
+    if (id_fila == FILA_AM) return &cache.am;
+    return &cache.a1out;
+}
+
+size_t cache_balde(size_t pagina) {
+    return (pagina * 2654435761u) & (cache.num_baldes - 1);
+}
+
+int cache_buscar(size_t pagina) {
+    for (int d = cache.baldes[cache_balde(pagina)]; d != -1; d = cache.descritores[d].proximo_hash) {
+        if (cache.descritores[d].pagina == pagina) return d;
+    }
+    return -1;
+}
+
+void cache_remover_hash(int d) {
+    int* elo = &cache.baldes[cache_balde(cache.descritores[d].pagina)];
+    while (*elo != d) elo = &cache.descritores[*elo].proximo_hash;
+    *elo = cache.descritores[d].proximo_hash;
+}
+
+// Descarta o descritor por completo (sai da fila, do hash e devolve o quadro, se tiver)
+void cache_descartar(int d) {
+    DescritorCache* desc = &cache.descritores[d];
+    fila_cache_remover(fila_cache(desc->fila), d);
+    cache_remover_hash(d);
+    if (desc->quadro != -1) cache.quadros_livres[cache.num_quadros_livres++] = desc->quadro;
+    desc->quadro = -1;
+    desc->fila = FILA_NENHUMA;
+    desc->proximo_hash = cache.descritores_livres;
+    cache.descritores_livres = d;
+}
+
+// Libera um quadro de dados, expulsando uma pgina se necessrio
+void cache_reservar_quadro() {
+    if (cache.num_quadros_livres > 0) return;
+
+    if (cache.a1in.tamanho > cache.kin || cache.am.tamanho == 0) {
+        // A cauda de A1in vira fantasma em A1out
+        int d = fila_cache_remover(&cache.a1in, cache.a1in.cauda);
+        cache.quadros_livres[cache.num_quadros_livres++] = cache.descritores[d].quadro;
+        cache.descritores[d].quadro = -1;
+        if (cache.a1out.tamanho >= cache.kout) cache_descartar(cache.a1out.cauda);
+        fila_cache_inserir(&cache.a1out, d, FILA_A1OUT);
+    }
+    else {
+        cache_descartar(cache.am.cauda);
+    }
+}
+
+// Coloca no cache uma pgina cujos dados esto em 'dados'; retorna o descritor
+int cache_inserir(size_t pagina, const unsigned char* dados) {
+    int d = cache_buscar(pagina);
+    if (d != -1 && cache.descritores[d].quadro != -1) return d;
+
+    cache_reservar_quadro();
+    // A expulso pode ter descartado o fantasma desta mesma pgina
+    d = cache_buscar(pagina);
+    int fila = FILA_A1IN;
+    if (d != -1) {
+        // Fantasma em A1out: a pgina voltou a ser usada, ento vai para Am
+        fila_cache_remover(&cache.a1out, d);
+        fila = FILA_AM;
+    }
+    else {
+        d = cache.descritores_livres;
+        cache.descritores_livres = cache.descritores[d].proximo_hash;
+        cache.descritores[d].pagina = pagina;
+        cache.descritores[d].proximo_hash = cache.baldes[cache_balde(pagina)];
+        cache.baldes[cache_balde(pagina)] = d;
+    }
+
+    cache.descritores[d].quadro = cache.quadros_livres[--cache.num_quadros_livres];
+    memcpy(cache.dados + (size_t)cache.descritores[d].quadro * CACHE_PAGE_SIZE, dados, CACHE_PAGE_SIZE);
+    fila_cache_inserir(fila_cache(fila), d, fila);
+    return d;
+}
+
+// Retorna os dados da pgina, lendo do disco (com leitura antecipada) em caso de falta
+unsigned char* cache_acessar(size_t pagina) {
+    int sequencial = pagina == cache.ultima_pagina + 1;
+    cache.ultima_pagina = pagina;
+
+    int d = cache_buscar(pagina);
+    if (d != -1 && cache.descritores[d].quadro != -1) {
+        cache.acertos++;
+        if (cache.descritores[d].fila == FILA_AM) {
+            fila_cache_remover(&cache.am, d);
+            fila_cache_inserir(&cache.am, d, FILA_AM);
+        }
+        return cache.dados + (size_t)cache.descritores[d].quadro * CACHE_PAGE_SIZE;
+    }
+
+    cache.faltas++;
+
+    // Acesso sequencial: l tambm as prximas pginas em uma nica operao
+    size_t paginas = sequencial ? cache.readahead : 1;
+    fseek(disco_virtual, pagina * CACHE_PAGE_SIZE, SEEK_SET);
+    size_t lidos = fread(cache.leitura, 1, paginas * CACHE_PAGE_SIZE, disco_virtual);
+    memset(cache.leitura + lidos, 0, paginas * CACHE_PAGE_SIZE - lidos);
+
+    // As antecipadas entram primeiro para que a pgina pedida seja a mais recente
+    for (size_t i = 1; i < paginas; i++) {
+        int existente = cache_buscar(pagina + i);
+        if (existente != -1 && cache.descritores[existente].quadro != -1) continue;
+        if (existente != -1) continue; // Fantasma: deixa para um acesso real promover a Am
+        cache_inserir(pagina + i, cache.leitura + i * CACHE_PAGE_SIZE);
+        cache.antecipadas++;
+    }
+    d = cache_inserir(pagina, cache.leitura);
+
+    return cache.dados + (size_t)cache.descritores[d].quadro * CACHE_PAGE_SIZE;
+}
+
+void cache_liberar() {
+    free(cache.dados);
+    free(cache.descritores);
+    free(cache.baldes);
+    free(cache.quadros_livres);
+    free(cache.leitura);
+    memset(&cache, 0, sizeof(cache));
+}
+
+// Configura o cache com 'bytes' de memria para pginas (0 desativa o cache)
+void cache_iniciar(size_t bytes) {
+    cache_liberar();
+
+    size_t num_quadros = bytes / CACHE_PAGE_SIZE;
+    if (num_quadros < 4) return;
+
+    size_t kout = num_quadros / 2;
+    size_t num_descritores = num_quadros + kout + 1;
+    size_t num_baldes = 1;
+    while (num_baldes < num_descritores) num_baldes <<= 1;
+
+    cache.num_quadros = num_quadros;
+    cache.kin = num_quadros / 4;
+    cache.kout = kout;
+    cache.readahead = CACHE_READAHEAD < num_quadros / 4 ? CACHE_READAHEAD : num_quadros / 4;
+    cache.num_baldes = num_baldes;
+    cache.dados = malloc(num_quadros * CACHE_PAGE_SIZE);
+    cache.descritores = malloc(num_descritores * sizeof(DescritorCache));
+    cache.baldes = malloc(num_baldes * sizeof(int));
+    cache.quadros_livres = malloc(num_quadros * sizeof(int));
+    cache.leitura = malloc(cache.readahead * CACHE_PAGE_SIZE);
+
+    if (!cache.dados || !cache.descritores || !cache.baldes || !cache.quadros_livres || !cache.leitura) {
+        printf("Aviso: Falha ao alocar memria para o cache de blocos. Cache desativado.\n");
+        cache_liberar();
+        return;
+    }
+
+    for (size_t i = 0; i < num_baldes; i++) cache.baldes[i] = -1;
+    for (size_t i = 0; i < num_descritores; i++) {
+        cache.descritores[i].quadro = -1;
+        cache.descritores[i].fila = FILA_NENHUMA;
+        cache.descritores[i].proximo_hash = i + 1 < num_descritores ? (int)(i + 1) : -1;
+    }
+    cache.descritores_livres = 0;
+    for (size_t i = 0; i < num_quadros; i++) cache.quadros_livres[i] = (int)(num_quadros - 1 - i);
+    cache.num_quadros_livres = num_quadros;
+    cache.a1in.cabeca = cache.a1in.cauda = -1;
+    cache.am.cabeca = cache.am.cauda = -1;
+    cache.a1out.cabeca = cache.a1out.cauda = -1;
+    cache.ultima_pagina = (size_t)-2;
+}
+
+// L 'quantidade' elementos de 'tamanho' bytes a partir da posio absoluta 'posicao' do disco.
+// Leituras pequenas passam pelo cache; leituras grandes (ordenao, varreduras) vo direto ao disco
+size_t ler_disco(void* destino, size_t tamanho, size_t quantidade, size_t posicao) {
+    size_t bytes = tamanho * quantidade;
+
+    EnterCriticalSection(&trava_disco);
+
+    if (cache.num_quadros == 0 || bytes >= CACHE_LEITURA_DIRETA) {
+        cache.leituras_diretas++;
+        fseek(disco_virtual, posicao, SEEK_SET);
+        size_t lidos = fread(destino, tamanho, quantidade, disco_virtual);
+        LeaveCriticalSection(&trava_disco);
+        return lidos;
+    }
+
+    unsigned char* saida = (unsigned char*)destino;
+    size_t copiados = 0;
+    while (copiados < bytes) {
+        size_t pagina = (posicao + copiados) / CACHE_PAGE_SIZE;
+        size_t deslocamento = (posicao + copiados) % CACHE_PAGE_SIZE;
+        size_t trecho = CACHE_PAGE_SIZE - deslocamento;
+        if (trecho > bytes - copiados) trecho = bytes - copiados;
+
+        memcpy(saida + copiados, cache_acessar(pagina) + deslocamento, trecho);
+        copiados += trecho;
+    }
+
+    LeaveCriticalSection(&trava_disco);
+    return quantidade;
+}
+
+// Copia dados recm-escritos no disco para as pginas que estiverem no cache
+void cache_atualizar(const void* origem, size_t bytes, size_t posicao) {
+    if (cache.num_quadros == 0 || bytes == 0) return;
+
+    const unsigned char* entrada = (const unsigned char*)origem;
+    size_t primeira = posicao / CACHE_PAGE_SIZE;
+    size_t ultima = (posicao + bytes - 1) / CACHE_PAGE_SIZE;
+
+    // Escritas maiores que o cache: percorrer os quadros  mais barato que consultar cada pgina
+    if (ultima - primeira + 1 > cache.num_quadros) {
+        for (size_t q = 0; q < cache.num_quadros + cache.kout + 1; q++) {
+            DescritorCache* desc = &cache.descritores[q];
+            if (desc->quadro == -1 || desc->pagina < primeira || desc->pagina > ultima) continue;
+            size_t inicio_pagina = desc->pagina * CACHE_PAGE_SIZE;
+            size_t de = inicio_pagina > posicao ? inicio_pagina : posicao;
+            size_t ate = inicio_pagina + CACHE_PAGE_SIZE < posicao + bytes ? inicio_pagina + CACHE_PAGE_SIZE : posicao + bytes;
+            memcpy(cache.dados + (size_t)desc->quadro * CACHE_PAGE_SIZE + (de - inicio_pagina), entrada + (de - posicao), ate - de);
+        }
+        return;
+    }
+
+    for (size_t pagina = primeira; pagina <= ultima; pagina++) {
+        int d = cache_buscar(pagina);
+        if (d == -1 || cache.descritores[d].quadro == -1) continue;
+        size_t inicio_pagina = pagina * CACHE_PAGE_SIZE;
+        size_t de = inicio_pagina > posicao ? inicio_pagina : posicao;
+        size_t ate = inicio_pagina + CACHE_PAGE_SIZE < posicao + bytes ? inicio_pagina + CACHE_PAGE_SIZE : posicao + bytes;
+        memcpy(cache.dados + (size_t)cache.descritores[d].quadro * CACHE_PAGE_SIZE + (de - inicio_pagina), entrada + (de - posicao), ate - de);
+    }
+}
+
+// Escreve no disco e mantm coerentes as pginas que estiverem no cache
+size_t escrever_disco(const void* origem, size_t tamanho, size_t quantidade, size_t posicao) {
+    EnterCriticalSection(&trava_disco);
+    fseek(disco_virtual, posicao, SEEK_SET);
+    size_t escritos = fwrite(origem, tamanho, quantidade, disco_virtual);
+
+    cache_atualizar(origem, tamanho * escritos, posicao);
+    LeaveCriticalSection(&trava_disco);
+
+    return escritos;
+}
+
+// fflush do disco virtual sob a trava, para os caminhos usados pelas threads de ordenar_lote
+void descarregar_disco() {
+    EnterCriticalSection(&trava_disco);
+    fflush(disco_virtual);
+    LeaveCriticalSection(&trava_disco);
+}
+
+// E/S direta
+// Um segundo handle do disco aberto com FILE_FLAG_NO_BUFFERING (o equivalente Windows de O_DIRECT)
+// faz as grandes transferncias de ordenar, criar e concatenar sem passar pelo cache do sistema.
+// Exige posio, tamanho e endereo do buffer alinhados a BLOCK_SIZE: os blocos do alocador j so,
+// e os buffers vm de VirtualAlloc. O que no estiver alinhado segue pelo caminho com buffer (stdio).
+
+void abrir_disco_direto() {
+    disco_direto = CreateFileA(caminho_disco, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL);
+
+    if (disco_direto == INVALID_HANDLE_VALUE) {
+        printf("Aviso: E/S direta indisponvel (Erro %d). Usando E/S com buffer.\n", GetLastError());
+        modo_io_direto = 0;
+    }
+}
+
+// Bytes do incio da transferncia que podem seguir pelo handle direto (0 se nenhum)
+size_t prefixo_direto(const void* buffer, size_t bytes, size_t posicao) {
+    if (!modo_io_direto || disco_direto == INVALID_HANDLE_VALUE) return 0;
+    if ((uintptr_t)buffer % BLOCK_SIZE != 0 || posicao % BLOCK_SIZE != 0) return 0;
+    return bytes - bytes % BLOCK_SIZE;
+}
+
+// Transfere 'bytes' alinhados pelo handle direto, em partes que cabem em um DWORD
+int transferir_direto(void* buffer, size_t bytes, size_t posicao, int escrita) {
+    // Dados ainda no buffer do stdio precisam chegar ao sistema antes de uma leitura ou escrita direta.
+    // As transferncias diretas em si no precisam da trava: cada uma leva sua prpria posio
+    descarregar_disco();
+
+    size_t feitos = 0;
+    while (feitos < bytes) {
+        DWORD parte = (DWORD)((bytes - feitos) < IO_DIRETO_MAX_TRANSFERENCIA ? (bytes - feitos) : IO_DIRETO_MAX_TRANSFERENCIA);
+        DWORD transferidos = 0;
+        OVERLAPPED ov = { 0 };
+        ov.Offset = (DWORD)((posicao + feitos) & 0xFFFFFFFF);
+        ov.OffsetHigh = (DWORD)((unsigned long long)(posicao + feitos) >> 32);
+
+        BOOL ok = escrita
+            ? WriteFile(disco_direto, (char*)buffer + feitos, parte, &transferidos, &ov)
+            : ReadFile(disco_direto, (char*)buffer + feitos, parte, &transferidos, &ov);
+        if (!ok || transferidos != parte) {
+            printf("Aviso: Falha na E/S direta (Erro %d). Usando E/S com buffer.\n", GetLastError());
+            modo_io_direto = 0;
+            return 0;
+        }
+        feitos += parte;
+    }
+    return 1;
+}
+
+// Como ler_disco, mas a parte alinhada da transferncia vai direto ao disco
+size_t ler_disco_direto(void* destino, size_t tamanho, size_t quantidade, size_t posicao) {
+    size_t bytes = tamanho * quantidade;
+    size_t direto = prefixo_direto(destino, bytes, posicao);
+
+    if (direto == 0 || !transferir_direto(destino, direto, posicao, 0)) {
+        return ler_disco(destino, tamanho, quantidade, posicao);
+    }
+
+    if (direto < bytes) {
+        ler_disco((char*)destino + direto, 1, bytes - direto, posicao + direto);
+    }
+    return quantidade;
+}
+
+// Como escrever_disco, mas a parte alinhada da transferncia vai direto ao disco
+size_t escrever_disco_direto(const void* origem, size_t tamanho, size_t quantidade, size_t posicao) {
+    size_t bytes = tamanho * quantidade;
+    size_t direto = prefixo_direto(origem, bytes, posicao);
+
+    if (direto == 0 || !transferir_direto((void*)origem, direto, posicao, 1)) {
+        return escrever_disco(origem, tamanho, quantidade, posicao);
+    }
+
+    EnterCriticalSection(&trava_disco);
+    cache_atualizar(origem, direto, posicao);
+    LeaveCriticalSection(&trava_disco);
+    if (direto < bytes) {
+        escrever_disco((const char*)origem + direto, 1, bytes - direto, posicao + direto);
+    }
+    return quantidade;
+}
+
+void estatisticas_cache() {
+    size_t acessos = cache.acertos + cache.faltas;
+    printf("Cache de blocos: %zu pginas de %d bytes (%zu KB)\n", cache.num_quadros, CACHE_PAGE_SIZE,
+        cache.num_quadros * CACHE_PAGE_SIZE / 1024);
+    printf("  Em uso: %zu em A1in, %zu em Am, %zu fantasmas em A1out\n",
+        cache.a1in.tamanho, cache.am.tamanho, cache.a1out.tamanho);
+    printf("  Acertos: %zu  Faltas: %zu  Taxa de acerto: %.1f%%\n", cache.acertos, cache.faltas,
+        acessos ? 100.0 * cache.acertos / acessos : 0.0);
+    printf("  Pginas antecipadas: %zu  Leituras diretas (sem cache): %zu\n", cache.antecipadas, cache.leituras_diretas);
+}
+
 void EnableLargePagePrivilege() {
     HANDLE hToken;
     TOKEN_PRIVILEGES tp;
@@ -331,8 +1085,11 @@ void EnableLargePagePrivilege() {
     }
 }
 
-void* allocateLargePage() {
-    SIZE_T size = LARGE_PAGE_SIZE; // 2MB (Large Page Size)
+// Aloca 'tamanho' bytes em Large Pages (arredondado para mltiplos da Large Page)
+void* allocateLargePages(SIZE_T tamanho) {
+    SIZE_T large_page_minimum = GetLargePageMinimum();
+    if (large_page_minimum == 0) large_page_minimum = LARGE_PAGE_SIZE;
+    SIZE_T size = (tamanho + large_page_minimum - 1) / large_page_minimum * large_page_minimum;
     void* pMemory = NULL;
 
     // Try to enable Large Page support
@@ -366,10 +1123,14 @@ void* allocateLargePage() {
     else {
         printf("Memory allocation failed. Error: %d\n", GetLastError());
         // Fallback to malloc if VirtualAlloc fails
-        return malloc(LARGE_PAGE_SIZE);
+        return malloc(size);
     }
 }
 
+void* allocateLargePage() {
+    return allocateLargePages(LARGE_PAGE_SIZE); // 2MB (Large Page Size)
+}
+
 // Liberar a memria da Large Page
 void freeLargePage(void* pMemory) {
     if (pMemory) {
@@ -385,6 +1146,288 @@ void freeLargePage(void* pMemory) {
     }
 }
 
+// Buffer alinhado  pgina (exigncia da E/S direta) para transferncias que no cabem na Large Page
+void* alocar_alinhado(size_t tamanho) {
+    return VirtualAlloc(NULL, tamanho > 0 ? tamanho : 1, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void liberar_alinhado(void* pMemory) {
+    if (pMemory) VirtualFree(pMemory, 0, MEM_RELEASE);
+}
+
+// Copia 'bytes' entre duas regies do disco usando o buffer dado
+void copiar_no_disco(size_t origem, size_t destino, size_t bytes, void* buffer, size_t buffer_bytes) {
+    size_t copiados = 0;
+    while (copiados < bytes) {
+        size_t parte = (bytes - copiados) < buffer_bytes ? (bytes - copiados) : buffer_bytes;
+        ler_disco_direto(buffer, 1, parte, origem + copiados);
+        escrever_disco_direto(buffer, 1, parte, destino + copiados);
+        copiados += parte;
+    }
+    descarregar_disco();
+}
+
+// Oramento de memria da ordenao derivado da memria fsica disponvel
+size_t orcamento_automatico() {
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    size_t orcamento = LARGE_PAGE_SIZE;
+
+    if (GlobalMemoryStatusEx(&status)) {
+        orcamento = (size_t)(status.ullAvailPhys / ORCAMENTO_FRACAO_MEMORIA);
+    }
+    if (orcamento > ORCAMENTO_MAXIMO) orcamento = ORCAMENTO_MAXIMO;
+
+    return orcamento;
+}
+
+// Memria que uma ordenao vai usar: o pedido, ou o padro global, ou o automtico.
+// Nunca menos que uma Large Page, nem mais do que o necessrio para o arquivo inteiro
+size_t orcamento_efetivo(size_t pedido, size_t tamanho_arquivo) {
+    size_t orcamento = pedido;
+    if (orcamento == 0) orcamento = orcamento_ordenacao_padrao;
+    if (orcamento == 0) orcamento = orcamento_automatico();
+
+    size_t necessario = (tamanho_arquivo + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE * LARGE_PAGE_SIZE;
+    if (orcamento > necessario) orcamento = necessario;
+
+    orcamento = orcamento / LARGE_PAGE_SIZE * LARGE_PAGE_SIZE;
+    if (orcamento < LARGE_PAGE_SIZE) orcamento = LARGE_PAGE_SIZE;
+
+    return orcamento;
+}
+
+// Divide o oramento entre 'fan_in' buffers de entrada e um de sada (em elementos de 'tamanho_elemento' bytes).
+// Cada entrada recebe o dobro da sada (40/40/20 com fan-in 2), e os tamanhos so mltiplos de
+// BLOCK_SIZE, mantendo as transferncias alinhadas para a E/S direta
+void planejar_buffers_mesclagem(size_t orcamento, int fan_in, size_t tamanho_elemento, size_t* entrada, size_t* saida) {
+    size_t elementos_por_bloco = BLOCK_SIZE / tamanho_elemento;
+    size_t unidade = orcamento / tamanho_elemento / (2 * fan_in + 1);
+
+    *entrada = 2 * unidade / elementos_por_bloco * elementos_por_bloco;
+    *saida = unidade / elementos_por_bloco * elementos_por_bloco;
+}
+
+// Tipos de elemento
+// As rotinas que comparam elementos so geradas uma vez por tipo pela macro DEFINIR_KERNELS, com a
+// comparao expandida no lugar (sem callback como no qsort). O resto do cdigo escolhe as rotinas
+// pela tabela 'tipos' e as chama uma vez por bloco de dados, no por elemento.
+
+// rand() do MSVC gera s 15 bits por chamada
+unsigned long long aleatorio64() {
+    unsigned long long v = 0;
+    for (int i = 0; i < 5; i++) {
+        v = (v << 15) | (unsigned long long)(rand() & 0x7FFF);
+    }
+    return v;
+}
+
+#define MENOR_ESCALAR(a, b) ((a) < (b))
+#define MENOR_CHAVE(a, b) ((a).chave < (b).chave)
+
+#define IMPRIMIR_INT32(x) printf("%d ", (x))
+#define IMPRIMIR_INT64(x) printf("%lld ", (x))
+#define IMPRIMIR_UINT32(x) printf("%u ", (x))
+#define IMPRIMIR_REAL(x) printf("%g ", (double)(x))
+#define IMPRIMIR_CHAVE_VALOR(x) printf("(%lld, %lld) ", (x).chave, (x).valor)
+
+#define GERAR_INT32(v, i) ((v)[i] = rand() % 1000000) // Mesma faixa de sempre de 'criar'
+#define GERAR_INT64(v, i) ((v)[i] = (long long)aleatorio64())
+#define GERAR_UINT32(v, i) ((v)[i] = (unsigned int)aleatorio64())
+#define GERAR_FLOAT(v, i) ((v)[i] = (float)(aleatorio64() % 100000000) / 100.0f)
+#define GERAR_DOUBLE(v, i) ((v)[i] = (double)(aleatorio64() >> 11) / (double)(1ULL << 53) * 1000000.0)
+#define GERAR_CHAVE_VALOR(v, i) ((v)[i].chave = (long long)aleatorio64(), (v)[i].valor = (long long)(i))
+
+#define DEFINIR_KERNELS(SUF, T, MENOR, IMPRIMIR, GERAR)                                                   \
+/* Com 'maiores' o heap guarda o menor na raiz (para achar os maiores); sem, o maior */                  \
+void heap_subir_##SUF(T* heap, size_t i, int maiores) {                                                  \
+    while (i > 0) {                                                                                      \
+        size_t pai = (i - 1) / 2;                                                                        \
+        int trocar = maiores ? MENOR(heap[i], heap[pai]) : MENOR(heap[pai], heap[i]);                    \
+        if (!trocar) break;                                                                              \
+        T tmp = heap[i]; heap[i] = heap[pai]; heap[pai] = tmp;                                           \
+        i = pai;                                                                                         \
+    }                                                                                                    \
+}                                                                                                        \
+                                                                                                         \
+void heap_descer_##SUF(T* heap, size_t n, size_t i, int maiores) {                                       \
+    while (1) {                                                                                          \
+        size_t esq = 2 * i + 1;                                                                          \
+        size_t dir = esq + 1;                                                                            \
+        size_t alvo = i;                                                                                 \
+        if (esq < n && (maiores ? MENOR(heap[esq], heap[alvo]) : MENOR(heap[alvo], heap[esq]))) alvo = esq; \
+        if (dir < n && (maiores ? MENOR(heap[dir], heap[alvo]) : MENOR(heap[alvo], heap[dir]))) alvo = dir; \
+        if (alvo == i) break;                                                                            \
+        T tmp = heap[i]; heap[i] = heap[alvo]; heap[alvo] = tmp;                                         \
+        i = alvo;                                                                                        \
+    }                                                                                                    \
+}                                                                                                        \
+                                                                                                         \
+/* Introsort: quicksort com mediana de trs, insero nos trechos pequenos e heapsort se degenerar */   \
+void introsort_##SUF(T* v, size_t n, int profundidade) {                                                 \
+    while (n > 16) {                                                                                     \
+        if (profundidade-- == 0) {                                                                       \
+            for (size_t i = n / 2; i > 0; i--) heap_descer_##SUF(v, n, i - 1, 0);                        \
+            for (size_t i = n - 1; i > 0; i--) {                                                         \
+                T tmp = v[0]; v[0] = v[i]; v[i] = tmp;                                                   \
+                heap_descer_##SUF(v, i, 0, 0);                                                           \
+            }                                                                                            \
+            return;                                                                                      \
+        }                                                                                                \
+                                                                                                         \
+        size_t meio = n / 2;                                                                             \
+        T tmp;                                                                                           \
+        if (MENOR(v[meio], v[0])) { tmp = v[meio]; v[meio] = v[0]; v[0] = tmp; }                         \
+        if (MENOR(v[n - 1], v[meio])) { tmp = v[n - 1]; v[n - 1] = v[meio]; v[meio] = tmp; }             \
+        if (MENOR(v[meio], v[0])) { tmp = v[meio]; v[meio] = v[0]; v[0] = tmp; }                         \
+        T pivo = v[meio];                                                                                \
+                                                                                                         \
+        size_t i = 0, j = n - 1;                                                                         \
+        while (1) {                                                                                      \
+            while (MENOR(v[i], pivo)) i++;                                                               \
+            while (MENOR(pivo, v[j])) j--;                                                               \
+            if (i >= j) break;                                                                           \
+            tmp = v[i]; v[i] = v[j]; v[j] = tmp;                                                         \
+            i++;                                                                                         \
+            j--;                                                                                         \
+        }                                                                                                \
+                                                                                                         \
+        /* Recurso na parte menor, lao na maior: a pilha fica em O(log n) */                           \
+        size_t esquerda = j + 1;                                                                         \
+        if (esquerda < n - esquerda) {                                                                   \
+            introsort_##SUF(v, esquerda, profundidade);                                                  \
+            v += esquerda;                                                                               \
+            n -= esquerda;                                                                               \
+        }                                                                                                \
+        else {                                                                                           \
+            introsort_##SUF(v + esquerda, n - esquerda, profundidade);                                   \
+            n = esquerda;                                                                                \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    for (size_t i = 1; i < n; i++) {                                                                     \
+        T x = v[i];                                                                                      \
+        size_t j = i;                                                                                    \
+        while (j > 0 && MENOR(x, v[j - 1])) { v[j] = v[j - 1]; j--; }                                    \
+        v[j] = x;                                                                                        \
+    }                                                                                                    \
+}                                                                                                        \
+                                                                                                         \
+void ordenar_memoria_##SUF(void* dados, size_t n) {                                                      \
+    int profundidade = 0;                                                                                \
+    for (size_t m = n; m > 1; m /= 2) profundidade += 2;                                                 \
+    introsort_##SUF((T*)dados, n, profundidade);                                                         \
+}                                                                                                        \
+                                                                                                         \
+/* Intercala at esgotar uma das entradas ou encher a sada; as posies avanam no lugar */             \
+void intercalar_blocos_##SUF(const void* a, size_t na, size_t* ia, const void* b, size_t nb, size_t* ib, \
+    void* saida, size_t ns, size_t* is) {                                                                \
+    const T* x = (const T*)a;                                                                            \
+    const T* y = (const T*)b;                                                                            \
+    T* out = (T*)saida;                                                                                  \
+    size_t i = *ia, j = *ib, k = *is;                                                                    \
+    while (i < na && j < nb && k < ns) {                                                                 \
+        if (MENOR(y[j], x[i])) out[k++] = y[j++];                                                        \
+        else out[k++] = x[i++];                                                                          \
+    }                                                                                                    \
+    *ia = i;                                                                                             \
+    *ib = j;                                                                                             \
+    *is = k;                                                                                             \
+}                                                                                                        \
+                                                                                                         \
+int em_ordem_##SUF(const void* dados, size_t n) {                                                        \
+    const T* v = (const T*)dados;                                                                        \
+    for (size_t i = 1; i < n; i++) {                                                                     \
+        if (MENOR(v[i], v[i - 1])) return 0;                                                             \
+    }                                                                                                    \
+    return 1;                                                                                            \
+}                                                                                                        \
+                                                                                                         \
+/* Passa os 'n' elementos pelo heap dos 'limite' maiores (ou menores) */                                 \
+void selecionar_##SUF(const void* dados, size_t n, void* heap_dados, size_t* tamanho_heap, size_t limite, int maiores) { \
+    const T* v = (const T*)dados;                                                                        \
+    T* heap = (T*)heap_dados;                                                                            \
+    size_t h = *tamanho_heap;                                                                            \
+    for (size_t i = 0; i < n; i++) {                                                                     \
+        if (h < limite) {                                                                                \
+            heap[h] = v[i];                                                                              \
+            heap_subir_##SUF(heap, h++, maiores);                                                        \
+        }                                                                                                \
+        else if (maiores ? MENOR(heap[0], v[i]) : MENOR(v[i], heap[0])) {                                \
+            heap[0] = v[i];                                                                              \
+            heap_descer_##SUF(heap, h, 0, maiores);                                                      \
+        }                                                                                                \
+    }                                                                                                    \
+    *tamanho_heap = h;                                                                                   \
+}                                                                                                        \
+                                                                                                         \
+/* Esvaziar o heap do fim para o incio deixa o resultado do melhor para o pior */                       \
+void esvaziar_heap_##SUF(void* heap_dados, size_t n, int maiores) {                                      \
+    T* heap = (T*)heap_dados;                                                                            \
+    for (; n > 1; n--) {                                                                                 \
+        T tmp = heap[0]; heap[0] = heap[n - 1]; heap[n - 1] = tmp;                                       \
+        heap_descer_##SUF(heap, n - 1, 0, maiores);                                                      \
+    }                                                                                                    \
+}                                                                                                        \
+                                                                                                         \
+void imprimir_##SUF(const void* dados, size_t n) {                                                       \
+    const T* v = (const T*)dados;                                                                        \
+    for (size_t i = 0; i < n; i++) {                                                                     \
+        IMPRIMIR(v[i]);                                                                                  \
+    }                                                                                                    \
+}                                                                                                        \
+                                                                                                         \
+void gerar_##SUF(void* dados, size_t n) {                                                                \
+    T* v = (T*)dados;                                                                                    \
+    for (size_t i = 0; i < n; i++) {                                                                     \
+        GERAR(v, i);                                                                                     \
+    }                                                                                                    \
+}
+
+DEFINIR_KERNELS(int32, int, MENOR_ESCALAR, IMPRIMIR_INT32, GERAR_INT32)
+DEFINIR_KERNELS(int64, long long, MENOR_ESCALAR, IMPRIMIR_INT64, GERAR_INT64)
+DEFINIR_KERNELS(uint32, unsigned int, MENOR_ESCALAR, IMPRIMIR_UINT32, GERAR_UINT32)
+DEFINIR_KERNELS(float, float, MENOR_ESCALAR, IMPRIMIR_REAL, GERAR_FLOAT)
+DEFINIR_KERNELS(double, double, MENOR_ESCALAR, IMPRIMIR_REAL, GERAR_DOUBLE)
+DEFINIR_KERNELS(chave_valor, RegistroChaveValor, MENOR_CHAVE, IMPRIMIR_CHAVE_VALOR, GERAR_CHAVE_VALOR)
+
+#define OPERACOES(SUF, T) { #SUF, sizeof(T), ordenar_memoria_##SUF, intercalar_blocos_##SUF, em_ordem_##SUF, \
+    selecionar_##SUF, esvaziar_heap_##SUF, imprimir_##SUF, gerar_##SUF }
+
+// Na ordem do enum TIPO_*
+const OperacoesTipo tipos[NUM_TIPOS] = {
+    OPERACOES(int32, int),
+    OPERACOES(int64, long long),
+    OPERACOES(uint32, unsigned int),
+    OPERACOES(float, float),
+    OPERACOES(double, double),
+    OPERACOES(chave_valor, RegistroChaveValor),
+};
+
+// Tipo pelo nome usado nos comandos ("int32", "chave_valor", ...), ou -1
+int tipo_por_nome(const char* nome) {
+    for (int t = 0; t < NUM_TIPOS; t++) {
+        if (strcmp(tipos[t].nome, nome) == 0) return t;
+    }
+    return -1;
+}
+
+const OperacoesTipo* operacoes(const Arquivo* arquivo) {
+    int tipo = arquivo->tipo >= 0 && arquivo->tipo < NUM_TIPOS ? arquivo->tipo : TIPO_INT32;
+    return &tipos[tipo];
+}
+
+// Inverte a ordem de 'n' elementos de 'tamanho' bytes (at 16)
+void inverter_elementos(void* dados, size_t n, size_t tamanho) {
+    unsigned char* v = (unsigned char*)dados;
+    unsigned char tmp[16];
+    for (size_t i = 0; i < n / 2; i++) {
+        memcpy(tmp, v + i * tamanho, tamanho);
+        memcpy(v + i * tamanho, v + (n - 1 - i) * tamanho, tamanho);
+        memcpy(v + (n - 1 - i) * tamanho, tmp, tamanho);
+    }
+}
+
 // Find
 
 Arquivo* find(const char* nome) {
@@ -400,53 +1443,74 @@ Arquivo* find(const char* nome) {
     return NULL;
 }
 
-// Criar
-void criar(const char* nome, int tamanho) {
-
-    // Marca o tempo de incio
-    clock_t start_time = clock();
-
+// Reserva a extenso e a entrada no catlogo de um novo arquivo, sem escrever dados
+Arquivo* alocar_arquivo(const char* nome, size_t file_size) {
     if (find(nome) != NULL) {
         printf("Erro: Arquivo '%s' j existe.\n", nome);
-        return;
+        return NULL;
+    }
+
+    if (sa.quantidade_arquivos >= MAX_FILES) {
+        printf("Erro: Limite de %d arquivos atingido\n", MAX_FILES);
+        return NULL;
     }
 
-    size_t file_size = tamanho * sizeof(int);
     if (file_size > sa.espaco_livre) {
         printf("Erro: Sem espao suficiente\n");
-        return;
+        return NULL;
     }
 
     // Encontrar espao livre (exemplo: first-fit)
     size_t posicao = encontrar_bloco_livre(file_size);
     if (posicao == -1) {
         printf("Erro: No h espao suficiente no disco.\n");
-        return;
+        return NULL;
     }
 
     Arquivo* arquivo = &sa.arquivos[sa.quantidade_arquivos++];
     strncpy(arquivo->nome, nome, MAX_FILENAME_LENGTH);
     arquivo->tamanho = file_size;
     arquivo->posicao = posicao;
+    arquivo->ordenado = 0;
+    arquivo->tipo = TIPO_INT32;
     sa.espaco_livre -= file_size;
 
-    // Criar e armazenar nmeros aleatrios no arquivo
-    int* numbers = malloc(file_size); // Permitido usar
+    return arquivo;
+}
+
+// Criar
+void criar_tipado(const char* nome, int tamanho, int tipo) {
+
+    // Marca o tempo de incio
+    clock_t start_time = clock();
+
+    if (tamanho <= 0) {
+        printf("Erro: Tamanho invlido\n");
+        return;
+    }
+
+    const OperacoesTipo* ops = &tipos[tipo];
+    size_t file_size = (size_t)tamanho * ops->tamanho;
+    Arquivo* arquivo = alocar_arquivo(nome, file_size);
+    if (!arquivo) {
+        return;
+    }
+    arquivo->tipo = tipo;
+
+    // Criar e armazenar valores aleatrios no arquivo
+    void* numbers = alocar_alinhado(file_size);
     if (!numbers) {
         printf("Erro: Falha ao alocar memria para os nmeros\n");
         return;
     }
 
-    for (int i = 0; i < tamanho; i++) {
-        numbers[i] = rand() % 1000000; // Nmeros aleatrios entre 0 e 999999
-    }
+    ops->gerar(numbers, tamanho);
 
     // Posicionar ponteiro do arquivo na posio correta e escrever os dados
-    fseek(disco_virtual, arquivo->posicao, SEEK_SET);
-    fwrite(numbers, sizeof(int), tamanho, disco_virtual);
+    escrever_disco_direto(numbers, ops->tamanho, tamanho, arquivo->posicao);
     fflush(disco_virtual);  // Garante que os dados so gravados imediatamente
 
-    free(numbers); // Liberar memria aps a gravao
+    liberar_alinhado(numbers); // Liberar memria aps a gravao
 
     salvar_estado();
 
@@ -457,6 +1521,10 @@ void criar(const char* nome, int tamanho) {
     printf("Arquivo '%s' criado com sucesso em %.2f ms\n", nome, duration);
 }
 
+void criar(const char* nome, int tamanho) {
+    criar_tipado(nome, tamanho, TIPO_INT32);
+}
+
 // Apagar
 void apagar(const char* nome) {
     int indice = -1;
@@ -479,15 +1547,8 @@ void apagar(const char* nome) {
 
     // Limpar o espao do arquivo no disco
     // Liberar os blocos no bitmap
-    size_t bloco_inicial = arquivo->posicao / BLOCK_SIZE;
-    size_t num_blocos = arquivo->tamanho / BLOCK_SIZE;
-
-    for (size_t i = 0; i < num_blocos; i++) {
-        sa.bitmap[bloco_inicial + i] = 0;  // Marca o bloco como livre
-    }
-
-    // Atualizar espao livre
-    sa.espaco_livre += arquivo->tamanho;
+    // Atualizar espao livre (blocos ainda usados por clones continuam ocupados)
+    sa.espaco_livre += liberar_blocos(arquivo->posicao, arquivo->tamanho);
 
     // Remover o arquivo da lista de arquivos
     for (int j = indice; j < sa.quantidade_arquivos - 1; j++) {
@@ -498,7 +1559,12 @@ void apagar(const char* nome) {
 
     salvar_estado();
 
-    printf("Arquivo '%s' excludo com sucesso\n", nome);
+    // Sem o arquivo ou o pagefile, uma ordenao interrompida no pode mais continuar
+    if (ponto_de_controle.ativo && (strcmp(nome, ponto_de_controle.nome) == 0 || strcmp(nome, "pagefile") == 0)) {
+        descartar_ponto_de_controle();
+    }
+
+    printf("Arquivo '%s' excludo com sucesso\n", nome);
 }
 
 // Concatenar
@@ -511,50 +1577,155 @@ void concatenar(const char* nome1, const char* nome2) {
         return;
     }
 
-    size_t novo_tamanho = arquivo1->tamanho + arquivo2->tamanho;
-    if (novo_tamanho > sa.espaco_livre + arquivo1->tamanho + arquivo2->tamanho) {
-        printf("Erro: No h espao suficiente em disco\n");
+    if (arquivo1 == arquivo2) {
+        printf("Erro: Os arquivos a concatenar devem ser diferentes\n");
         return;
     }
 
-    // Criar buffer para armazenar contedo de arquivo2
-    char* buffer = malloc(arquivo2->tamanho);
+    if (arquivo1->tipo != arquivo2->tipo) {
+        printf("Erro: '%s'  %s e '%s'  %s\n", nome1, operacoes(arquivo1)->nome, nome2, operacoes(arquivo2)->nome);
+        return;
+    }
+
+    size_t novo_tamanho = arquivo1->tamanho + arquivo2->tamanho;
+
+    // Se os blocos logo aps arquivo1 estiverem livres, ele cresce no lugar;
+    // seno o resultado vai para uma nova extenso contgua.
+    // Um arquivo que divide blocos com um clone nunca cresce no lugar: o fim de arquivo2 seria escrito no
+    // ltimo bloco, que tambm  do clone. A cpia para a nova extenso j  o copy-on-write
+    size_t blocos_atuais = arquivo1->tamanho / BLOCK_SIZE + (arquivo1->tamanho % BLOCK_SIZE != 0);
+    size_t blocos_novos = novo_tamanho / BLOCK_SIZE + (novo_tamanho % BLOCK_SIZE != 0);
+    size_t primeiro_bloco = arquivo1->posicao / BLOCK_SIZE + blocos_atuais;
+    int no_lugar = primeiro_bloco + (blocos_novos - blocos_atuais) <= NUM_BLOCOS_DADOS &&
+        !extensao_compartilhada(arquivo1->posicao, arquivo1->tamanho);
+    for (size_t i = 0; no_lugar && i < blocos_novos - blocos_atuais; i++) {
+        if (!bloco_esta_livre(primeiro_bloco + i)) no_lugar = 0;
+    }
+
+    size_t destino = arquivo1->posicao;
+    if (no_lugar) {
+        for (size_t i = 0; i < blocos_novos - blocos_atuais; i++) {
+            marcar_bloco_ocupado(primeiro_bloco + i);
+        }
+    }
+    else {
+        destino = encontrar_bloco_livre(novo_tamanho);
+        if (destino == -1) {
+            printf("Erro: No h espao suficiente em disco\n");
+            return;
+        }
+    }
+
+    // Buffer alinhado para as cpias (E/S direta)
+    void* buffer = allocateLargePage();
     if (!buffer) {
         printf("Erro: Falha ao alocar memria\n");
         return;
     }
 
-    // Ler contedo de arquivo2
-    fseek(disco_virtual, arquivo2->posicao, SEEK_SET);
-    fread(buffer, 1, arquivo2->tamanho, disco_virtual);
+    if (no_lugar) {
+        sa.espaco_livre -= arquivo2->tamanho;
+    }
+    else {
+        copiar_no_disco(arquivo1->posicao, destino, arquivo1->tamanho, buffer, LARGE_PAGE_SIZE);
+        sa.espaco_livre -= novo_tamanho;
+        sa.espaco_livre += liberar_blocos(arquivo1->posicao, arquivo1->tamanho);
+        arquivo1->posicao = destino;
+    }
 
     // Escrever contedo de arquivo2 no final de arquivo1
-    fseek(disco_virtual, arquivo1->posicao + arquivo1->tamanho, SEEK_SET);
-    fwrite(buffer, 1, arquivo2->tamanho, disco_virtual);
-    fflush(disco_virtual);  // Garantir que os dados foram gravados
+    copiar_no_disco(arquivo2->posicao, destino + arquivo1->tamanho, arquivo2->tamanho, buffer, LARGE_PAGE_SIZE);
 
-    sa.espaco_livre += arquivo1->tamanho;
-    arquivo1->tamanho = novo_tamanho;
+    freeLargePage(buffer);
 
-    free(buffer);
+    arquivo1->tamanho = novo_tamanho;
+    arquivo1->ordenado = 0;
 
     printf("Arquivos '%s' e '%s' foram concatenados com sucesso\n", nome1, nome2);
 
     apagar(nome2);
 
-    sa.espaco_livre -= novo_tamanho;
+    salvar_estado();
+}
+
+// Clonar: novo arquivo que compartilha os blocos do original (copy-on-write)
+void clonar(const char* origem, const char* destino) {
+    Arquivo* arquivo = find(origem);
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado\n", origem);
+        return;
+    }
+
+    if (find(destino) != NULL) {
+        printf("Erro: Arquivo '%s' j existe.\n", destino);
+        return;
+    }
+
+    if (sa.quantidade_arquivos >= MAX_FILES) {
+        printf("Erro: Limite de %d arquivos atingido\n", MAX_FILES);
+        return;
+    }
+
+    size_t bloco_inicial = arquivo->posicao / BLOCK_SIZE;
+    size_t num_blocos = arquivo->tamanho / BLOCK_SIZE + (arquivo->tamanho % BLOCK_SIZE != 0);
+    for (size_t i = 0; i < num_blocos; i++) {
+        if (sa.referencias[bloco_inicial + i] == USHRT_MAX) {
+            printf("Erro: Limite de clones do arquivo '%s' atingido\n", origem);
+            return;
+        }
+    }
+    for (size_t i = 0; i < num_blocos; i++) {
+        sa.referencias[bloco_inicial + i]++;
+    }
+
+    // Nenhum dado  copiado nem espao consumido at uma das cpias ser modificada
+    Arquivo* clone = &sa.arquivos[sa.quantidade_arquivos++];
+    *clone = *arquivo;
+    strncpy(clone->nome, destino, MAX_FILENAME_LENGTH);
 
     salvar_estado();
+
+    printf("Arquivo '%s' clonado em '%s'\n", origem, destino);
+}
+
+// Copy-on-write: antes de modificar um arquivo no lugar, d a ele blocos exclusivos.
+// Retorna 0 se a cpia no foi possvel
+int garantir_exclusivo(Arquivo* arquivo) {
+    if (!extensao_compartilhada(arquivo->posicao, arquivo->tamanho)) return 1;
+
+    size_t nova_posicao = encontrar_bloco_livre(arquivo->tamanho);
+    if (nova_posicao == -1) {
+        printf("Erro: No h espao para a cpia (copy-on-write) de '%s'\n", arquivo->nome);
+        return 0;
+    }
+
+    void* buffer = allocateLargePage();
+    if (!buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        liberar_blocos(nova_posicao, arquivo->tamanho);
+        return 0;
+    }
+
+    copiar_no_disco(arquivo->posicao, nova_posicao, arquivo->tamanho, buffer, LARGE_PAGE_SIZE);
+    freeLargePage(buffer);
+
+    sa.espaco_livre -= arquivo->tamanho;
+    sa.espaco_livre += liberar_blocos(arquivo->posicao, arquivo->tamanho);
+    arquivo->posicao = nova_posicao;
+
+    printf("Copy-on-write: '%s' agora tem blocos prprios\n", arquivo->nome);
+    return 1;
 }
 
 // Listar
 void listar() {
     //printf("Arquivos:\n");
     printf("Listagem de arquivos:\n");
-    printf("%-32s %-15s\n", "Nome", "Tamanho (bytes)");
+    printf("%-32s %-15s %-12s\n", "Nome", "Tamanho (bytes)", "Tipo");
     printf("--------------------------------------------------------------\n");
     for (int i = 0; i < sa.quantidade_arquivos; i++) {
-        printf(" % -32s % -15zu\n", sa.arquivos[i].nome, sa.arquivos[i].tamanho);
+        printf(" % -32s % -15zu %-12s%s\n", sa.arquivos[i].nome, sa.arquivos[i].tamanho, operacoes(&sa.arquivos[i])->nome,
+            extensao_compartilhada(sa.arquivos[i].posicao, sa.arquivos[i].tamanho) ? " (compartilhado)" : "");
     }
     if (sa.quantidade_arquivos == 0) {
         printf("Nenhum arquivo encontrado.\n");
@@ -580,26 +1751,26 @@ void ler(const char* nome, int inicio, int fim) {
         return;
     }
 
-    int num_count = arquivo->tamanho / sizeof(int);
+    const OperacoesTipo* ops = operacoes(arquivo);
+    int num_count = arquivo->tamanho / ops->tamanho;
 
     if (inicio < 0 || fim >= num_count || inicio > fim) {
         printf("Error: Invalid range\n");
         return;
     }
 
-    int* buffer = malloc(arquivo->tamanho);
+    // Ler apenas o intervalo pedido (intervalos pequenos so servidos pelo cache de blocos)
+    int quantidade = fim - inicio + 1;
+    void* buffer = malloc(quantidade * ops->tamanho);
     if (!buffer) {
         printf("Erro: Falha ao alocar memria\n");
         return;
     }
 
-    fseek(disco_virtual, arquivo->posicao, SEEK_SET);
-    fread(buffer, sizeof(int), num_count, disco_virtual);
+    ler_disco(buffer, ops->tamanho, quantidade, arquivo->posicao + inicio * ops->tamanho);
 
     printf("Nmeros %d a %d no arquivo '%s':\n", inicio, fim, nome);
-    for (int i = inicio; i <= fim; i++) {
-        printf("%d ", buffer[i]);
-    }
+    ops->imprimir(buffer, quantidade);
     printf("\n");
 
     // Liberar memria
@@ -607,289 +1778,2299 @@ void ler(const char* nome, int inicio, int fim) {
 }
 
 
-int comparar(const void* a, const void* b) {
-    return (*(int*)a - *(int*)b);
-}
-
-// Funo auxiliar para criar o arquivo pagefile
-size_t criar_pagefile(size_t tamanho_necessario) {
-    // Verificar se pagefile j existe
-    for (int i = 0; i < sa.quantidade_arquivos; i++) {
-        if (strcmp(sa.arquivos[i].nome, "pagefile") == 0) {
-            // Apaga o pagefile existente
-            apagar("pagefile");
-            break;
-        }
-    }
-    if(find("pagefile") != NULL) apagar("pagefile");
+// Importar / Exportar
+// Movem arquivos entre o sistema de arquivos do host e o disco virtual. O formato binrio  o prprio
+// contedo do arquivo (inteiros de 32 bits little-endian); o texto tem um inteiro por linha.
+// Os dados passam em blocos grandes por um buffer alinhado, com a parte do disco virtual feita por E/S direta.
 
-    // Criar novo pagefile
-    size_t nums_inteiros = tamanho_necessario / sizeof(int);
-    criar("pagefile", nums_inteiros);
+enum { TEXTO_OK, TEXTO_FORA_DA_FAIXA, TEXTO_MAL_FORMADO };
 
-    // Encontrar o arquivo pagefile criado
-    Arquivo* pagefile = NULL;
-    for (int i = 0; i < sa.quantidade_arquivos; i++) {
-        if (strcmp(sa.arquivos[i].nome, "pagefile") == 0) {
-            pagefile = &sa.arquivos[i];
-            break;
+// Estado do analisador de texto, preservado entre um bloco lido e o prximo
+typedef struct {
+    long long valor;
+    int negativo;
+    int em_numero;
+    int erro;       // TEXTO_*; guarda o primeiro erro encontrado
+} EstadoTexto;
+
+// Extrai os inteiros de 'texto' para 'saida' (ou s conta, se 'saida' for NULL). Qualquer caractere
+// que no seja dgito ou '-' separa nmeros; '-' s pode iniciar um nmero ("3-4", "--5" e "-" sozinho
+// so erros). Retorna quantos nmeros terminaram neste bloco
+size_t analisar_inteiros(const char* texto, size_t n, EstadoTexto* estado, int* saida) {
+    size_t encontrados = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        char c = texto[i];
+        if (c >= '0' && c <= '9') {
+            // Fora da faixa de int o nmero j  um erro; parar de acumular evita estourar o long long
+            if (estado->valor <= (long long)INT_MAX + 1) estado->valor = estado->valor * 10 + (c - '0');
+            if (estado->valor > (long long)INT_MAX + 1 && !estado->erro) estado->erro = TEXTO_FORA_DA_FAIXA;
+            estado->em_numero = 1;
+        }
+        else if (c == '-') {
+            if ((estado->em_numero || estado->negativo) && !estado->erro) estado->erro = TEXTO_MAL_FORMADO;
+            estado->negativo = 1;
+        }
+        else {
+            if (estado->negativo && !estado->em_numero && !estado->erro) estado->erro = TEXTO_MAL_FORMADO;
+            if (estado->em_numero) {
+                long long v = estado->negativo ? -estado->valor : estado->valor;
+                if (v > INT_MAX && !estado->erro) estado->erro = TEXTO_FORA_DA_FAIXA;
+                if (saida) saida[encontrados] = (int)v;
+                encontrados++;
+            }
+            estado->valor = 0;
+            estado->negativo = 0;
+            estado->em_numero = 0;
         }
     }
 
-    if (!pagefile) {
-        printf("Erro: Falha ao criar pagefile\n");
-        return -1;
-    }
+    return encontrados;
+}
 
-    return pagefile->posicao;
+// Finaliza o nmero que estiver em andamento no fim da entrada
+size_t finalizar_analise(EstadoTexto* estado, int* saida) {
+    return analisar_inteiros("\n", 1, estado, saida);
 }
 
-// Funo para mesclar dois segmentos ordenados
-void merge_runs_improved(void* huge_buffer, size_t arquivo_pos, size_t run1_start, size_t run1_end,
-    size_t run2_start, size_t run2_end, size_t pagefile_pos) {
-    // Verificao de limites
-    if (run1_end < run1_start || run2_end < run2_start) {
-        printf("Erro: Limites de runs invlidos\n");
+// Tamanho do arquivo do host, ou -1 se no puder ser aberto
+long long tamanho_arquivo_host(FILE* host) {
+    if (_fseeki64(host, 0, SEEK_END) != 0) return -1;
+    long long tamanho = _ftelli64(host);
+    _fseeki64(host, 0, SEEK_SET);
+    return tamanho;
+}
+
+void importar(const char* caminho, const char* nome) {
+    clock_t start_time = clock();
+
+    FILE* host = fopen(caminho, "rb");
+    if (!host) {
+        printf("Erro: No foi possvel abrir '%s'\n", caminho);
         return;
     }
 
-    // Calcular tamanhos dos runs
-    size_t run1_size = run1_end - run1_start + 1;
-    size_t run2_size = run2_end - run2_start + 1;
-    size_t merged_size = run1_size + run2_size;
+    long long tamanho = tamanho_arquivo_host(host);
+    if (tamanho <= 0 || tamanho % sizeof(int) != 0) {
+        printf("Erro: '%s' no contm um nmero inteiro de valores de %zu bytes\n", caminho, sizeof(int));
+        fclose(host);
+        return;
+    }
 
-    //printf("Mesclando runs - Run1: %zu elementos (%zu-%zu), Run2: %zu elementos (%zu-%zu)\n",
-    //    run1_size, run1_start, run1_end, run2_size, run2_start, run2_end);
+    void* buffer = allocateLargePages(TRANSFERENCIA_HOST);
+    if (!buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        fclose(host);
+        return;
+    }
 
-    // Dividir os 2MB da Large Page:
-    // - 40% (0.8MB) para buffer1
-    // - 40% (0.8MB) para buffer2
-    // - 20% (0.4MB) para out_buffer
-    size_t buffer_size = LARGE_PAGE_SIZE * 0.4 / sizeof(int);      // ~0.8MB em inteiros
-    size_t out_buffer_size = LARGE_PAGE_SIZE * 0.2 / sizeof(int);  // ~0.4MB em inteiros
+    Arquivo* arquivo = alocar_arquivo(nome, (size_t)tamanho);
+    if (!arquivo) {
+        freeLargePage(buffer);
+        fclose(host);
+        return;
+    }
+
+    size_t copiados = 0;
+    while (copiados < (size_t)tamanho) {
+        size_t parte = ((size_t)tamanho - copiados) < TRANSFERENCIA_HOST ? ((size_t)tamanho - copiados) : TRANSFERENCIA_HOST;
+        size_t lidos = fread(buffer, 1, parte, host);
+        if (lidos != parte) {
+            printf("Erro: Leitura de '%s' interrompida\n", caminho);
+            break;
+        }
+        escrever_disco_direto(buffer, 1, parte, arquivo->posicao + copiados);
+        copiados += parte;
+    }
+    fflush(disco_virtual);
 
-    int* buffer1 = (int*)huge_buffer;                              // Incio da Large Page
-    int* buffer2 = buffer1 + buffer_size;                          // Aps buffer1
-    int* out_buffer = buffer2 + buffer_size;                       // Aps buffer2
+    freeLargePage(buffer);
+    fclose(host);
 
-    // Verificar se a diviso cabe nos 2MB
-    if ((buffer_size + buffer_size + out_buffer_size) * sizeof(int) > LARGE_PAGE_SIZE) {
-        printf("Erro: Diviso dos buffers excede Large Page\n");
+    if (copiados < (size_t)tamanho) {
+        apagar(nome);
         return;
     }
 
-    // Posies atuais em cada run
-    size_t pos1 = run1_start;
-    size_t pos2 = run2_start;
-    size_t output_count = 0;
-    size_t output_pos = 0;
+    salvar_estado();
 
-    // Buffers de leitura para cada run
-    size_t buf1_size = 0;  // Elementos vlidos no buffer1
-    size_t buf2_size = 0;  // Elementos vlidos no buffer2
-    size_t buf1_pos = 0;   // Posio atual no buffer1
-    size_t buf2_pos = 0;   // Posio atual no buffer2
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("'%s' importado como '%s' (%zu inteiros) em %.2f ms\n", caminho, nome, copiados / sizeof(int), duration);
+}
+
+void exportar(const char* nome, const char* caminho) {
+    clock_t start_time = clock();
 
-    // Carregar dados iniciais nos buffers
-    if (pos1 <= run1_end) {
-        size_t read_size = (run1_end - pos1 + 1) < buffer_size ? (run1_end - pos1 + 1) : buffer_size;
-        fseek(disco_virtual, arquivo_pos + pos1 * sizeof(int), SEEK_SET);
-        buf1_size = fread(buffer1, sizeof(int), read_size, disco_virtual);
-        pos1 += buf1_size;
+    Arquivo* arquivo = find(nome);
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado\n", nome);
+        return;
     }
 
-    if (pos2 <= run2_end) {
-        size_t read_size = (run2_end - pos2 + 1) < buffer_size ? (run2_end - pos2 + 1) : buffer_size;
-        fseek(disco_virtual, arquivo_pos + pos2 * sizeof(int), SEEK_SET);
-        buf2_size = fread(buffer2, sizeof(int), read_size, disco_virtual);
-        pos2 += buf2_size;
+    FILE* host = fopen(caminho, "wb");
+    if (!host) {
+        printf("Erro: No foi possvel criar '%s'\n", caminho);
+        return;
     }
 
-    // Enquanto houver dados a processar
-    while (buf1_pos < buf1_size || buf2_pos < buf2_size) {
-        // Decidir qual elemento pegar
-        if (buf1_pos < buf1_size && (buf2_pos >= buf2_size || buffer1[buf1_pos] <= buffer2[buf2_pos])) {
-            out_buffer[output_count++] = buffer1[buf1_pos++];
-        }
-        else {
-            out_buffer[output_count++] = buffer2[buf2_pos++];
-        }
+    void* buffer = allocateLargePages(TRANSFERENCIA_HOST);
+    if (!buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        fclose(host);
+        return;
+    }
 
-        // Se o buffer de sada estiver cheio, escrever no pagefile
-        if (output_count == out_buffer_size) {
-            fseek(disco_virtual, pagefile_pos + output_pos * sizeof(int), SEEK_SET);
-            fwrite(out_buffer, sizeof(int), output_count, disco_virtual);
-            output_pos += output_count;
-            output_count = 0;
+    size_t copiados = 0;
+    while (copiados < arquivo->tamanho) {
+        size_t parte = (arquivo->tamanho - copiados) < TRANSFERENCIA_HOST ? (arquivo->tamanho - copiados) : TRANSFERENCIA_HOST;
+        ler_disco_direto(buffer, 1, parte, arquivo->posicao + copiados);
+        if (fwrite(buffer, 1, parte, host) != parte) {
+            printf("Erro: Escrita em '%s' interrompida\n", caminho);
+            break;
         }
+        copiados += parte;
+    }
 
-        // Recarregar buffer1 se necessrio
-        if (buf1_pos == buf1_size && pos1 <= run1_end) {
-            size_t read_size = (run1_end - pos1 + 1) < buffer_size ? (run1_end - pos1 + 1) : buffer_size;
-            fseek(disco_virtual, arquivo_pos + pos1 * sizeof(int), SEEK_SET);
-            buf1_size = fread(buffer1, sizeof(int), read_size, disco_virtual);
-            pos1 += buf1_size;
-            buf1_pos = 0;
-        }
+    freeLargePage(buffer);
+    fclose(host);
 
-        // Recarregar buffer2 se necessrio
-        if (buf2_pos == buf2_size && pos2 <= run2_end) {
-            size_t read_size = (run2_end - pos2 + 1) < buffer_size ? (run2_end - pos2 + 1) : buffer_size;
-            fseek(disco_virtual, arquivo_pos + pos2 * sizeof(int), SEEK_SET);
-            buf2_size = fread(buffer2, sizeof(int), read_size, disco_virtual);
-            pos2 += buf2_size;
-            buf2_pos = 0;
-        }
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("'%s' exportado para '%s' (%zu bytes) em %.2f ms\n", nome, caminho, copiados, duration);
+}
+
+void importar_texto(const char* caminho, const char* nome) {
+    clock_t start_time = clock();
+
+    FILE* host = fopen(caminho, "rb");
+    if (!host) {
+        printf("Erro: No foi possvel abrir '%s'\n", caminho);
+        return;
     }
 
-    // Escrever qualquer dado restante no pagefile
-    if (output_count > 0) {
-        fseek(disco_virtual, pagefile_pos + output_pos * sizeof(int), SEEK_SET);
-        fwrite(out_buffer, sizeof(int), output_count, disco_virtual);
-        output_pos += output_count;
+    // Os inteiros convertidos ficam no incio do buffer (alinhados para a E/S direta) e o texto no ltimo quarto.
+    // Cada nmero ocupa ao menos 2 caracteres, ento um bloco de texto rende no mximo 1/8 do buffer em inteiros
+    char* buffer = allocateLargePages(TRANSFERENCIA_HOST);
+    if (!buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        fclose(host);
+        return;
     }
+    size_t bloco_texto = TRANSFERENCIA_HOST / 4;
+    int* numeros = (int*)buffer;
+    char* texto = buffer + TRANSFERENCIA_HOST - bloco_texto;
+
+    // 1 leitura: contar os nmeros para reservar a extenso de uma vez
+    EstadoTexto estado = { 0 };
+    size_t total = 0;
+    size_t lidos;
+    while ((lidos = fread(texto, 1, bloco_texto, host)) > 0) {
+        total += analisar_inteiros(texto, lidos, &estado, NULL);
+    }
+    total += finalizar_analise(&estado, NULL);
 
-    // Copiar dados mesclados do pagefile de volta para o arquivo original
-    size_t total_written = 0;
-    size_t read_pos = 0;
+    if (estado.erro) {
+        if (estado.erro == TEXTO_FORA_DA_FAIXA) printf("Erro: '%s' contm valores fora do intervalo de int\n", caminho);
+        else printf("Erro: '%s' contm um nmero mal formado ('-' fora do incio de um nmero)\n", caminho);
+        freeLargePage(buffer);
+        fclose(host);
+        return;
+    }
+    if (total == 0) {
+        printf("Erro: '%s' no contm inteiros\n", caminho);
+        freeLargePage(buffer);
+        fclose(host);
+        return;
+    }
 
-    while (total_written < merged_size) {
-        size_t to_read = (merged_size - total_written) < out_buffer_size ?
-            (merged_size - total_written) : out_buffer_size;
-        fseek(disco_virtual, pagefile_pos + read_pos * sizeof(int), SEEK_SET);
-        size_t read = fread(out_buffer, sizeof(int), to_read, disco_virtual);
+    Arquivo* arquivo = alocar_arquivo(nome, total * sizeof(int));
+    if (!arquivo) {
+        freeLargePage(buffer);
+        fclose(host);
+        return;
+    }
 
-        if (read == 0) break;
+    // 2 leitura: converter e gravar. S blocos inteiros so gravados a cada passo, para que a posio
+    // no disco continue alinhada; o resto fica pendente no incio do buffer at a prxima leitura
+    _fseeki64(host, 0, SEEK_SET);
+    memset(&estado, 0, sizeof(estado));
+    size_t ints_por_bloco = BLOCK_SIZE / sizeof(int);
+    size_t gravados = 0;
+    size_t pendentes = 0;
+    size_t convertidos = 0;
+    while ((lidos = fread(texto, 1, bloco_texto, host)) > 0) {
+        size_t novos = analisar_inteiros(texto, lidos, &estado, numeros + pendentes);
+        convertidos += novos;
+        pendentes += novos;
+        if (gravados + pendentes > total) pendentes = total - gravados; // O arquivo cresceu entre as leituras
+
+        size_t completos = pendentes - pendentes % ints_por_bloco;
+        escrever_disco_direto(numeros, sizeof(int), completos, arquivo->posicao + gravados * sizeof(int));
+        memmove(numeros, numeros + completos, (pendentes - completos) * sizeof(int));
+        gravados += completos;
+        pendentes -= completos;
+    }
+    size_t finais = finalizar_analise(&estado, numeros + pendentes);
+    convertidos += finais;
+    pendentes += finais;
+    if (gravados + pendentes > total) pendentes = total - gravados;
+    escrever_disco(numeros, sizeof(int), pendentes, arquivo->posicao + gravados * sizeof(int));
+    fflush(disco_virtual);
 
-        fseek(disco_virtual, arquivo_pos + (run1_start + total_written) * sizeof(int), SEEK_SET);
-        fwrite(out_buffer, sizeof(int), read, disco_virtual);
+    freeLargePage(buffer);
+    fclose(host);
 
-        total_written += read;
-        read_pos += read;
+    // Se o arquivo mudou entre as leituras, parte da extenso reservada ficaria com lixo
+    if (convertidos != total || estado.erro) {
+        printf("Erro: '%s' mudou durante a importao (%zu inteiros na contagem, %zu na converso)\n",
+            caminho, total, convertidos);
+        apagar(nome);
+        return;
     }
 
-    fflush(disco_virtual);
+    salvar_estado();
 
-    //printf("Mesclagem concluda: %zu elementos mesclados\n", total_written);
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("'%s' importado como '%s' (%zu inteiros) em %.2f ms\n", caminho, nome, total, duration);
 }
 
-// Ordenar: implementar por ltimo
-void ordenar(const char* nome) {
-    clock_t start_time = clock();
+// Escreve 'valor' em decimal seguido de '\n' e retorna o nmero de caracteres
+size_t formatar_inteiro(int valor, char* saida) {
+    char digitos[12];
+    size_t n = 0;
+    size_t pos = 0;
+    unsigned int v = valor < 0 ? 0u - (unsigned int)valor : (unsigned int)valor;
+
+    do {
+        digitos[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    if (valor < 0) saida[pos++] = '-';
+    while (n > 0) saida[pos++] = digitos[--n];
+    saida[pos++] = '\n';
+    return pos;
+}
 
-    Arquivo* arquivo = NULL;
-    for (int i = 0; i < sa.quantidade_arquivos; i++) {
-        if (strcmp(sa.arquivos[i].nome, nome) == 0) {
-            arquivo = &sa.arquivos[i];
-            break;
-        }
-    }
+void exportar_texto(const char* nome, const char* caminho) {
+    clock_t start_time = clock();
 
+    Arquivo* arquivo = find(nome);
     if (!arquivo) {
-        printf("Erro: Arquivo '%s' no encontrado.\n", nome);
+        printf("Erro: Arquivo '%s' no encontrado\n", nome);
         return;
     }
 
-    size_t num_ints = arquivo->tamanho / sizeof(int);
-    printf("Ordenando arquivo '%s' com %zu inteiros (%zu bytes)\n", nome, num_ints, arquivo->tamanho);
-
-    void* huge_buffer = allocateLargePage();
-    if (!huge_buffer) {
-        printf("Erro: Falha ao alocar memria para ordenao\n");
+    if (arquivo->tipo != TIPO_INT32) {
+        printf("Erro: exportar_texto s aceita arquivos int32; use 'exportar' para '%s' (%s)\n", nome, operacoes(arquivo)->nome);
         return;
     }
 
-    int* buffer = (int*)huge_buffer;
-    size_t max_ints_in_memory = LARGE_PAGE_SIZE / sizeof(int);
+    FILE* host = fopen(caminho, "wb");
+    if (!host) {
+        printf("Erro: No foi possvel criar '%s'\n", caminho);
+        return;
+    }
 
-    if (num_ints <= max_ints_in_memory) {
-        printf("Arquivo cabe na memria. Usando ordenao direta...\n");
-        fseek(disco_virtual, arquivo->posicao, SEEK_SET);
-        fread(buffer, sizeof(int), num_ints, disco_virtual);
-        qsort(buffer, num_ints, sizeof(int), comparar);
-        fseek(disco_virtual, arquivo->posicao, SEEK_SET);
-        fwrite(buffer, sizeof(int), num_ints, disco_virtual);
-        fflush(disco_virtual);
+    // Cada inteiro vira no mximo 12 caracteres: 1/13 do buffer para os inteiros, o resto para o texto
+    char* buffer = allocateLargePages(TRANSFERENCIA_HOST);
+    if (!buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        fclose(host);
+        return;
     }
-    else {
-        printf("Arquivo excede 2MB, usando ordenao externa com paginao...\n");
+    size_t ints_por_bloco = BLOCK_SIZE / sizeof(int);
+    size_t max_ints = TRANSFERENCIA_HOST / 13 / sizeof(int) / ints_por_bloco * ints_por_bloco;
+    int* numeros = (int*)buffer;
+    char* texto = buffer + max_ints * sizeof(int);
 
-        size_t pagefile_pos = criar_pagefile(arquivo->tamanho * 2);
-        if (pagefile_pos == -1) {
-            freeLargePage(huge_buffer);
-            return;
+    size_t num_ints = arquivo->tamanho / sizeof(int);
+    size_t lidos = 0;
+    while (lidos < num_ints) {
+        size_t parte = (num_ints - lidos) < max_ints ? (num_ints - lidos) : max_ints;
+        ler_disco_direto(numeros, sizeof(int), parte, arquivo->posicao + lidos * sizeof(int));
+
+        size_t caracteres = 0;
+        for (size_t i = 0; i < parte; i++) {
+            caracteres += formatar_inteiro(numeros[i], texto + caracteres);
+        }
+        if (fwrite(texto, 1, caracteres, host) != caracteres) {
+            printf("Erro: Escrita em '%s' interrompida\n", caminho);
+            break;
         }
+        lidos += parte;
+    }
+
+    freeLargePage(buffer);
+    fclose(host);
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("'%s' exportado para '%s' (%zu inteiros) em %.2f ms\n", nome, caminho, lidos, duration);
+}
 
-        size_t num_segments = (num_ints + max_ints_in_memory - 1) / max_ints_in_memory;
-        printf("Dividindo em %zu segmentos...\n", num_segments);
+// Funo auxiliar para criar um pagefile (rea de rascunho da ordenao externa).
+// S reserva a extenso: o contedo  sempre escrito antes de ser lido
+size_t criar_pagefile(const char* nome, size_t tamanho_necessario) {
+    // Apaga um pagefile que tenha sobrado de uma ordenao anterior
+    if (find(nome) != NULL) apagar(nome);
 
-        for (size_t seg = 0; seg < num_segments; seg++) {
-            size_t start_idx = seg * max_ints_in_memory;
-            size_t end_idx = start_idx + max_ints_in_memory;
-            if (end_idx > num_ints) end_idx = num_ints;
-            size_t segment_size = end_idx - start_idx;
+    Arquivo* pagefile = alocar_arquivo(nome, tamanho_necessario);
+    if (!pagefile) {
+        printf("Erro: Falha ao criar %s\n", nome);
+        return -1;
+    }
 
-            //printf("Ordenando segmento %zu/%zu (%zu elementos)...\n", seg + 1, num_segments, segment_size);
-            fseek(disco_virtual, arquivo->posicao + start_idx * sizeof(int), SEEK_SET);
-            fread(buffer, sizeof(int), segment_size, disco_virtual);
-            qsort(buffer, segment_size, sizeof(int), comparar);
-            fseek(disco_virtual, arquivo->posicao + start_idx * sizeof(int), SEEK_SET);
-            fwrite(buffer, sizeof(int), segment_size, disco_virtual);
-            fflush(disco_virtual);
-        }
+    salvar_estado();
+    return pagefile->posicao;
+}
 
-        size_t run_size = max_ints_in_memory;
-        while (run_size < num_ints) {
-            //printf("Mesclando runs de tamanho %zu...\n", run_size);
+// Intercala duas sequncias ordenadas de elementos (posies absolutas no disco) em destino_pos.
+// A comparao fica no kernel do tipo, chamado uma vez a cada vez que um buffer esgota ou enche
+void intercalar_sequencias(void* huge_buffer, size_t orcamento, const OperacoesTipo* ops, size_t seq1_pos, size_t seq1_size,
+    size_t seq2_pos, size_t seq2_size, size_t destino_pos) {
+    // Dividir o oramento: dois buffers de entrada e um de sada (40/40/20)
+    size_t buffer_size, out_buffer_size;
+    planejar_buffers_mesclagem(orcamento, 2, ops->tamanho, &buffer_size, &out_buffer_size);
+
+    size_t tam = ops->tamanho;
+    char* buffer1 = (char*)huge_buffer;                            // Incio da Large Page
+    char* buffer2 = buffer1 + buffer_size * tam;                   // Aps buffer1
+    char* out_buffer = buffer2 + buffer_size * tam;                // Aps buffer2
+
+    // Verificar se a diviso cabe no oramento
+    if (out_buffer_size == 0 || (buffer_size + buffer_size + out_buffer_size) * tam > orcamento) {
+        printf("Erro: Diviso dos buffers excede o oramento de memria\n");
+        return;
+    }
 
-            for (size_t i = 0; i < num_ints; i += 2 * run_size) {
-                size_t run1_start = i;
-                size_t run1_end = i + run_size - 1;
-                if (run1_end >= num_ints) run1_end = num_ints - 1;
+    // Elementos j lidos de cada sequncia
+    size_t lidos1 = 0;
+    size_t lidos2 = 0;
+    size_t output_count = 0;
+    size_t output_pos = 0;
 
-                if (run1_end + 1 < num_ints) {
-                    size_t run2_start = run1_end + 1;
-                    size_t run2_end = run2_start + run_size - 1;
-                    if (run2_end >= num_ints) run2_end = num_ints - 1;
+    // Buffers de leitura para cada sequncia
+    size_t buf1_size = 0;  // Elementos vlidos no buffer1
+    size_t buf2_size = 0;  // Elementos vlidos no buffer2
+    size_t buf1_pos = 0;   // Posio atual no buffer1
+    size_t buf2_pos = 0;   // Posio atual no buffer2
 
-                    merge_runs_improved(huge_buffer, arquivo->posicao, run1_start, run1_end,
-                        run2_start, run2_end, pagefile_pos);
-                }
-            }
-            run_size *= 2;
+    while (1) {
+        // Recarregar os buffers que se esgotaram
+        if (buf1_pos == buf1_size && lidos1 < seq1_size) {
+            size_t read_size = (seq1_size - lidos1) < buffer_size ? (seq1_size - lidos1) : buffer_size;
+            buf1_size = ler_disco_direto(buffer1, tam, read_size, seq1_pos + lidos1 * tam);
+            lidos1 += buf1_size;
+            buf1_pos = 0;
+        }
+        if (buf2_pos == buf2_size && lidos2 < seq2_size) {
+            size_t read_size = (seq2_size - lidos2) < buffer_size ? (seq2_size - lidos2) : buffer_size;
+            buf2_size = ler_disco_direto(buffer2, tam, read_size, seq2_pos + lidos2 * tam);
+            lidos2 += buf2_size;
+            buf2_pos = 0;
         }
 
-        apagar("pagefile");
-    }
+        int resta1 = buf1_pos < buf1_size;
+        int resta2 = buf2_pos < buf2_size;
+        if (!resta1 && !resta2) break;
 
-    freeLargePage(huge_buffer);
+        if (resta1 && resta2) {
+            ops->intercalar(buffer1, buf1_size, &buf1_pos, buffer2, buf2_size, &buf2_pos,
+                out_buffer, out_buffer_size, &output_count);
+        }
+        else {
+            // Uma das sequncias acabou: o resto da outra  copiado sem comparaes
+            char* origem = resta1 ? buffer1 : buffer2;
+            size_t* pos = resta1 ? &buf1_pos : &buf2_pos;
+            size_t disponiveis = (resta1 ? buf1_size : buf2_size) - *pos;
+            size_t n = disponiveis < out_buffer_size - output_count ? disponiveis : out_buffer_size - output_count;
+            memcpy(out_buffer + output_count * tam, origem + *pos * tam, n * tam);
+            *pos += n;
+            output_count += n;
+        }
 
-    clock_t end_time = clock();
-    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+        // Se o buffer de sada estiver cheio, escrever no destino
+        if (output_count == out_buffer_size) {
+            escrever_disco_direto(out_buffer, tam, output_count, destino_pos + output_pos * tam);
+            output_pos += output_count;
+            output_count = 0;
+        }
+    }
 
-    salvar_estado();
+    // Escrever qualquer dado restante no destino
+    if (output_count > 0) {
+        escrever_disco_direto(out_buffer, tam, output_count, destino_pos + output_pos * tam);
+        output_pos += output_count;
+    }
 
-    printf("Arquivo '%s' ordenado em %.2f ms.\n", nome, duration);
+    descarregar_disco();
 }
 
+// Funo para mesclar dois segmentos ordenados
+void merge_runs_improved(void* huge_buffer, size_t orcamento, const OperacoesTipo* ops, size_t arquivo_pos,
+    size_t run1_start, size_t run1_end, size_t run2_start, size_t run2_end, size_t pagefile_pos) {
+    // Verificao de limites
+    if (run1_end < run1_start || run2_end < run2_start) {
+        printf("Erro: Limites de runs invlidos\n");
+        return;
+    }
 
-int main() {
+    // Calcular tamanhos dos runs
+    size_t run1_size = run1_end - run1_start + 1;
+    size_t run2_size = run2_end - run2_start + 1;
+    size_t merged_size = run1_size + run2_size;
 
-    iniciar_sistema_arquivos();
-    allocateLargePage();
+    //printf("Mesclando runs - Run1: %zu elementos (%zu-%zu), Run2: %zu elementos (%zu-%zu)\n",
+    //    run1_size, run1_start, run1_end, run2_size, run2_start, run2_end);
+
+    intercalar_sequencias(huge_buffer, orcamento, ops, arquivo_pos + run1_start * ops->tamanho, run1_size,
+        arquivo_pos + run2_start * ops->tamanho, run2_size, pagefile_pos);
+
+    // Copiar dados mesclados do pagefile de volta para o arquivo original,
+    // usando o oramento inteiro como buffer de cpia
+    copiar_no_disco(pagefile_pos, arquivo_pos + run1_start * ops->tamanho, merged_size * ops->tamanho,
+        huge_buffer, orcamento);
+
+    //printf("Mesclagem concluda: %zu elementos mesclados\n", merged_size);
+}
+
+// Pontos de controle da ordenao externa
+// Cada passo escreve primeiro no pagefile e registra a cpia pendente; s ento copia para o arquivo e
+// registra o passo como concludo. Uma queda no meio da cpia  resolvida refazendo a cpia, e em
+// qualquer ponto registrado o arquivo contm exatamente os elementos originais.
+
+void iniciar_ponto_de_controle(const char* nome, int tipo, size_t posicao, size_t num_elementos,
+    size_t pagefile_pos, size_t orcamento) {
+    PontoDeControle* ponto = &ponto_de_controle;
+    memset(ponto, 0, sizeof(PontoDeControle));
+    ponto->ativo = 1;
+    strncpy(ponto->nome, nome, MAX_FILENAME_LENGTH);
+    ponto->tipo = tipo;
+    ponto->posicao = posicao;
+    ponto->num_elementos = num_elementos;
+    ponto->pagefile_pos = pagefile_pos;
+    ponto->orcamento = orcamento;
+    ponto->fase = FASE_RUNS;
+
+    // Trabalho total: a gerao de runs mais uma leitura e escrita do arquivo por passada de mesclagem
+    size_t run_size = orcamento / tipos[tipo].tamanho;
+    ponto->total = num_elementos;
+    for (size_t r = run_size; r < num_elementos; r *= 2) {
+        ponto->total += num_elementos;
+    }
+
+    salvar_ponto_de_controle();
+}
+
+void registrar_copia(PontoDeControle* ponto, size_t origem, size_t destino, size_t bytes) {
+    ponto->copia_pendente = 1;
+    ponto->copia_origem = origem;
+    ponto->copia_destino = destino;
+    ponto->copia_bytes = bytes;
+    salvar_ponto_de_controle();
+}
+
+// Mostra quanto da ordenao j foi feito e estima o tempo restante pelo ritmo desta execuo
+void mostrar_progresso(PontoDeControle* ponto, clock_t inicio, size_t feitos_no_inicio) {
+    double percentual = ponto->total ? 100.0 * ponto->feitos / ponto->total : 100.0;
+    double decorrido = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+    size_t feitos_agora = ponto->feitos - feitos_no_inicio;
+
+    if (feitos_agora > 0 && decorrido > 0) {
+        double restante = decorrido * (ponto->total - ponto->feitos) / feitos_agora;
+        printf("\rProgresso: %5.1f%% - restante estimado: %.1f s     ", percentual, restante);
+    }
+    else {
+        printf("\rProgresso: %5.1f%%     ", percentual);
+    }
+    fflush(stdout);
+}
+
+void concluir_passo(PontoDeControle* ponto, size_t elementos, clock_t inicio, size_t feitos_no_inicio) {
+    ponto->copia_pendente = 0;
+    ponto->proximo++;
+    ponto->feitos += elementos;
+    salvar_ponto_de_controle();
+    mostrar_progresso(ponto, inicio, feitos_no_inicio);
+
+    // Queda simulada: sem fechar o disco nem salvar nada alm do que j foi gravado
+    if (interromper_apos_passos > 0 && --interromper_apos_passos == 0) {
+        printf("\nProcesso interrompido com %.1f%% concludo\n", 100.0 * ponto->feitos / ponto->total);
+        fflush(stdout);
+        TerminateProcess(GetCurrentProcess(), 1);
+    }
+}
+
+// Termina uma cpia que ficou pela metade. Retorna 0 se no foi possvel
+int concluir_copia_pendente() {
+    PontoDeControle* ponto = &ponto_de_controle;
+    if (!ponto->ativo || !ponto->copia_pendente) return 1;
+
+    if (ponto->copia_origem + ponto->copia_bytes > DISK_SIZE || ponto->copia_destino + ponto->copia_bytes > DISK_SIZE) {
+        descartar_ponto_de_controle();
+        return 0;
+    }
+
+    void* buffer = allocateLargePage();
+    if (!buffer) return 0;
+    copiar_no_disco(ponto->copia_origem, ponto->copia_destino, ponto->copia_bytes, buffer, LARGE_PAGE_SIZE);
+    freeLargePage(buffer);
+
+    ponto->copia_pendente = 0;
+    ponto->proximo++;
+    ponto->feitos += ponto->copia_bytes / tipos[ponto->tipo].tamanho;
+    salvar_ponto_de_controle();
+    return 1;
+}
+
+// Na inicializao: deixa o arquivo de uma ordenao interrompida consistente e avisa que ela pode continuar
+void verificar_ordenacao_interrompida() {
+    PontoDeControle* ponto = &ponto_de_controle;
+    if (!ponto->ativo) return;
+
+    if (ponto->tipo < 0 || ponto->tipo >= NUM_TIPOS || !concluir_copia_pendente()) {
+        printf("Aviso: Ponto de controle de ordenao invlido descartado\n");
+        descartar_ponto_de_controle();
+        return;
+    }
+
+    printf("Aviso: A ordenao de '%s' foi interrompida com %.1f%% concludo. Use 'ordenar %s' para continuar.\n",
+        ponto->nome, ponto->total ? 100.0 * ponto->feitos / ponto->total : 0.0, ponto->nome);
+}
+
+// O ponto de controle pertence a este arquivo, que no mudou de lugar nem de tamanho desde a interrupo?
+int ponto_de_controle_corresponde(Arquivo* arquivo) {
+    PontoDeControle* ponto = &ponto_de_controle;
+    if (!ponto->ativo || strcmp(ponto->nome, arquivo->nome) != 0) return 0;
+    if (ponto->tipo != arquivo->tipo || ponto->posicao != arquivo->posicao) return 0;
+    if (ponto->num_elementos != arquivo->tamanho / tipos[ponto->tipo].tamanho) return 0;
+
+    Arquivo* pagefile = find("pagefile");
+    return pagefile && pagefile->posicao == ponto->pagefile_pos && pagefile->tamanho >= arquivo->tamanho;
+}
+
+// S existe um ponto de controle e um "pagefile": recri-lo para outro arquivo perderia uma ordenao que ainda pode continuar
+int ponto_de_controle_ocupado(const char* nome) {
+    PontoDeControle* ponto = &ponto_de_controle;
+    if (!ponto->ativo || strcmp(ponto->nome, nome) == 0) return 0;
+
+    Arquivo* outro = find(ponto->nome);
+    if (!outro || !ponto_de_controle_corresponde(outro)) return 0;
+
+    printf("Erro: A ordenao interrompida de '%s' usa o pagefile. Use 'ordenar %s' para conclu-la ou 'apagar pagefile' para descart-la\n",
+        ponto->nome, ponto->nome);
+    return 1;
+}
+
+// Ncleo da ordenao: ordena no lugar os 'num_elementos' elementos em 'posicao' usando o buffer dado.
+// Se no couberem no oramento, faz ordenao externa com o pagefile em 'pagefile_pos'; com 'controle',
+// grava um ponto de controle a cada passo e comea de onde ele parou.
+// No mexe no catlogo, ento pode rodar em paralelo em extenses diferentes
+void ordenar_extensao(void* huge_buffer, size_t orcamento, const OperacoesTipo* ops, size_t posicao,
+    size_t num_elementos, size_t pagefile_pos, PontoDeControle* controle) {
+    size_t tam = ops->tamanho;
+    size_t max_in_memory = orcamento / tam;
+
+    if (num_elementos <= max_in_memory) {
+        ler_disco_direto(huge_buffer, tam, num_elementos, posicao);
+        ops->ordenar(huge_buffer, num_elementos);
+        escrever_disco_direto(huge_buffer, tam, num_elementos, posicao);
+        descarregar_disco();
+        return;
+    }
+
+    size_t num_segments = (num_elementos + max_in_memory - 1) / max_in_memory;
+    clock_t inicio = clock();
+    size_t feitos_no_inicio = controle ? controle->feitos : 0;
+
+    size_t primeiro_segmento = 0;
+    if (controle) {
+        primeiro_segmento = controle->fase == FASE_RUNS ? controle->proximo : num_segments;
+    }
+
+    for (size_t seg = primeiro_segmento; seg < num_segments; seg++) {
+        size_t start_idx = seg * max_in_memory;
+        size_t end_idx = start_idx + max_in_memory;
+        if (end_idx > num_elementos) end_idx = num_elementos;
+        size_t segment_size = end_idx - start_idx;
+
+        //printf("Ordenando segmento %zu/%zu (%zu elementos)...\n", seg + 1, num_segments, segment_size);
+        ler_disco_direto(huge_buffer, tam, segment_size, posicao + start_idx * tam);
+        ops->ordenar(huge_buffer, segment_size);
+        if (controle) {
+            escrever_disco_direto(huge_buffer, tam, segment_size, pagefile_pos + start_idx * tam);
+            registrar_copia(controle, pagefile_pos + start_idx * tam, posicao + start_idx * tam, segment_size * tam);
+        }
+        escrever_disco_direto(huge_buffer, tam, segment_size, posicao + start_idx * tam);
+        descarregar_disco();
+        if (controle) concluir_passo(controle, segment_size, inicio, feitos_no_inicio);
+    }
+
+    size_t run_size = max_in_memory;
+    size_t primeiro_par = 0;
+    if (controle) {
+        if (controle->fase == FASE_RUNS) {
+            controle->fase = FASE_MESCLAGEM;
+            controle->run_size = run_size;
+            controle->proximo = 0;
+            salvar_ponto_de_controle();
+        }
+        run_size = controle->run_size;
+        primeiro_par = controle->proximo;
+    }
+
+    while (run_size < num_elementos) {
+        //printf("Mesclando runs de tamanho %zu...\n", run_size);
+
+        for (size_t i = primeiro_par * 2 * run_size; i < num_elementos; i += 2 * run_size) {
+            size_t run1_start = i;
+            size_t run1_end = i + run_size - 1;
+            if (run1_end >= num_elementos) run1_end = num_elementos - 1;
+            size_t par_size = run1_end - run1_start + 1;
+
+            if (run1_end + 1 < num_elementos) {
+                size_t run2_start = run1_end + 1;
+                size_t run2_end = run2_start + run_size - 1;
+                if (run2_end >= num_elementos) run2_end = num_elementos - 1;
+                par_size += run2_end - run2_start + 1;
+
+                if (controle) {
+                    // Mesma mesclagem de merge_runs_improved, com a cpia de volta registrada antes de comear
+                    intercalar_sequencias(huge_buffer, orcamento, ops, posicao + run1_start * tam, run1_end - run1_start + 1,
+                        posicao + run2_start * tam, run2_end - run2_start + 1, pagefile_pos);
+                    registrar_copia(controle, pagefile_pos, posicao + run1_start * tam, par_size * tam);
+                    copiar_no_disco(pagefile_pos, posicao + run1_start * tam, par_size * tam, huge_buffer, orcamento);
+                }
+                else {
+                    merge_runs_improved(huge_buffer, orcamento, ops, posicao, run1_start, run1_end,
+                        run2_start, run2_end, pagefile_pos);
+                }
+            }
+            if (controle) concluir_passo(controle, par_size, inicio, feitos_no_inicio);
+        }
+        run_size *= 2;
+        primeiro_par = 0;
+
+        if (controle) {
+            controle->run_size = run_size;
+            controle->proximo = 0;
+            salvar_ponto_de_controle();
+        }
+    }
+
+    if (controle) printf("\n");
+}
+
+// Ordenar: implementar por ltimo
+// 'orcamento_pedido'  a memria da ordenao em bytes (0 usa o padro global)
+void ordenar(const char* nome, size_t orcamento_pedido) {
+    clock_t start_time = clock();
+
+    Arquivo* arquivo = NULL;
+    for (int i = 0; i < sa.quantidade_arquivos; i++) {
+        if (strcmp(sa.arquivos[i].nome, nome) == 0) {
+            arquivo = &sa.arquivos[i];
+            break;
+        }
+    }
+
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado.\n", nome);
+        return;
+    }
+
+    if (!garantir_exclusivo(arquivo)) {
+        return;
+    }
+
+    const OperacoesTipo* ops = operacoes(arquivo);
+    size_t num_elementos = arquivo->tamanho / ops->tamanho;
+    size_t posicao = arquivo->posicao;
+    printf("Ordenando arquivo '%s' com %zu elementos %s (%zu bytes)\n", nome, num_elementos, ops->nome, arquivo->tamanho);
+
+    // Uma ordenao interrompida deste arquivo continua com o mesmo oramento, que define os limites dos runs
+    int continuar = ponto_de_controle_corresponde(arquivo) && concluir_copia_pendente();
+    size_t orcamento = continuar ? ponto_de_controle.orcamento : orcamento_efetivo(orcamento_pedido, arquivo->tamanho);
+    printf("Oramento de memria: %zu MB\n", orcamento / (1024 * 1024));
+
+    void* huge_buffer = allocateLargePages(orcamento);
+    if (!huge_buffer) {
+        printf("Erro: Falha ao alocar memria para ordenao\n");
+        return;
+    }
+
+    size_t max_in_memory = orcamento / ops->tamanho;
+    size_t pagefile_pos = -1;
+
+    if (num_elementos <= max_in_memory) {
+        printf("Arquivo cabe na memria. Usando ordenao direta...\n");
+    }
+    else if (continuar) {
+        pagefile_pos = ponto_de_controle.pagefile_pos;
+        printf("Continuando a ordenao interrompida (%.1f%% concludo)...\n",
+            100.0 * ponto_de_controle.feitos / ponto_de_controle.total);
+    }
+    else {
+        printf("Arquivo excede o oramento de memria, usando ordenao externa com paginao...\n");
+
+        if (ponto_de_controle_ocupado(nome)) {
+            freeLargePage(huge_buffer);
+            return;
+        }
+        pagefile_pos = criar_pagefile("pagefile", arquivo->tamanho);
+        if (pagefile_pos == -1) {
+            freeLargePage(huge_buffer);
+            return;
+        }
+        iniciar_ponto_de_controle(nome, operacoes(arquivo) - tipos, posicao, num_elementos, pagefile_pos, orcamento);
+
+        printf("Dividindo em %zu segmentos...\n", (num_elementos + max_in_memory - 1) / max_in_memory);
+    }
+
+    ordenar_extensao(huge_buffer, orcamento, ops, posicao, num_elementos, pagefile_pos,
+        pagefile_pos != -1 ? &ponto_de_controle : NULL);
+
+    if (pagefile_pos != -1) {
+        descartar_ponto_de_controle();
+        apagar("pagefile");
+    }
+
+    freeLargePage(huge_buffer);
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+
+    // O pagefile pode ter deslocado entradas do catlogo; buscar o arquivo novamente
+    arquivo = find(nome);
+    if (arquivo) arquivo->ordenado = 1;
+
+    salvar_estado();
+
+    printf("Arquivo '%s' ordenado em %.2f ms.\n", nome, duration);
+}
+
+// Ordenao em lote
+// Cada ordenao  dividida em passos (um segmento da gerao de runs, ou um par de uma passada de
+// mesclagem), e os trabalhadores pegam passos de qualquer arquivo, dos maiores arquivos primeiro. Assim
+// os segmentos e os pares de um arquivo grande se espalham pelos trabalhadores, em vez de ficarem todos
+// com uma nica thread. Cada passo toma emprestadas pginas da arena do oramento global e as devolve ao
+// terminar; um par de mesclagem recebe uma parte igual da memria livre entre os passos que podem comear,
+// ento quando as outras ordenaes terminam a que sobrou fica com o oramento inteiro.
+// Toda alterao do catlogo (copy-on-write, pagefiles, marcao de ordenado) fica na thread principal,
+// antes e depois do lote; as threads s transferem dados e ordenam
+
+// Passos que j podem ser despachados (os pares de uma passada s existem quando a anterior termina)
+size_t passos_prontos(FilaLote* fila) {
+    size_t prontos = 0;
+    for (int t = 0; t < fila->num_tarefas; t++) {
+        TarefaOrdenacao* tarefa = &fila->tarefas[t];
+        if (tarefa->fase != FASE_CONCLUIDA) prontos += tarefa->num_passos - tarefa->proximo;
+    }
+    return prontos;
+}
+
+// Reserva pginas contguas da arena: as 'desejadas' na primeira sequncia livre que couber, ou, se nenhuma
+// couber, a maior sequncia livre com pelo menos 'minimo'. Retorna a primeira pgina, ou -1
+size_t reservar_paginas(FilaLote* fila, size_t minimo, size_t desejadas, size_t* obtidas) {
+    size_t maior_inicio = -1;
+    size_t maior = 0;
+    size_t i = 0;
+
+    while (i < fila->num_paginas) {
+        if (fila->paginas_ocupadas[i]) {
+            i++;
+            continue;
+        }
+
+        size_t inicio = i;
+        while (i < fila->num_paginas && !fila->paginas_ocupadas[i] && i - inicio < desejadas) i++;
+        if (i - inicio == desejadas) {
+            maior_inicio = inicio;
+            maior = desejadas;
+            break;
+        }
+        if (i - inicio > maior) {
+            maior_inicio = inicio;
+            maior = i - inicio;
+        }
+    }
+
+    if (maior == 0 || maior < minimo) return -1;
+
+    for (size_t p = maior_inicio; p < maior_inicio + maior; p++) fila->paginas_ocupadas[p] = 1;
+    fila->paginas_livres -= maior;
+    *obtidas = maior;
+    return maior_inicio;
+}
+
+// Escolhe o prximo passo e reserva a sua memria. Chamada com a trava; retorna 0 se nada pode comear agora
+int proximo_passo(FilaLote* fila, PassoLote* passo) {
+    size_t prontos = passos_prontos(fila);
+    if (prontos == 0) return 0;
+
+    // Parte de um par: a memria livre dividida entre os passos que podem comear agora
+    size_t comecando = prontos < (size_t)fila->ociosos ? prontos : (size_t)fila->ociosos;
+    size_t parte = fila->paginas_livres / (comecando > 0 ? comecando : 1);
+    if (parte == 0) parte = 1;
+
+    for (int t = 0; t < fila->num_tarefas; t++) {
+        TarefaOrdenacao* tarefa = &fila->tarefas[t];
+        if (tarefa->fase == FASE_CONCLUIDA || tarefa->proximo == tarefa->num_passos) continue;
+
+        size_t minimo, desejadas;
+        if (tarefa->fase == FASE_RUNS) {
+            // Os limites dos runs j foram fixados, ento o segmento precisa exatamente da sua memria
+            minimo = desejadas = tarefa->paginas_segmento;
+        }
+        else {
+            // Com 5/4 do par em memria (40/40/20) cada run  lido de uma vez; mais do que isso no ajuda
+            size_t par = 2 * tarefa->run_size * tipos[tarefa->tipo].tamanho;
+            if (par > tarefa->tamanho) par = tarefa->tamanho;
+            size_t util = (par + par / 4 + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE;
+            minimo = 1;
+            desejadas = parte < util ? parte : util;
+        }
+
+        size_t paginas;
+        size_t primeira = reservar_paginas(fila, minimo, desejadas, &paginas);
+        if (primeira == -1) continue;
+
+        passo->tarefa = t;
+        passo->fase = tarefa->fase;
+        passo->indice = tarefa->proximo++;
+        passo->run_size = tarefa->run_size;
+        passo->primeira_pagina = primeira;
+        passo->paginas = paginas;
+        tarefa->em_andamento++;
+        fila->ociosos--;
+        return 1;
+    }
+
+    return 0;
+}
+
+// Executa o passo sem a trava: os passos em andamento nunca se sobrepem no arquivo nem no pagefile
+void executar_passo(FilaLote* fila, PassoLote* passo) {
+    TarefaOrdenacao* tarefa = &fila->tarefas[passo->tarefa];
+    const OperacoesTipo* ops = &tipos[tarefa->tipo];
+    size_t tam = ops->tamanho;
+    void* buffer = fila->arena + passo->primeira_pagina * LARGE_PAGE_SIZE;
+    size_t orcamento = passo->paginas * LARGE_PAGE_SIZE;
+    size_t n = tarefa->num_elementos;
+
+    if (passo->fase == FASE_RUNS) {
+        size_t inicio = passo->indice * tarefa->segmento;
+        size_t tamanho = n - inicio < tarefa->segmento ? n - inicio : tarefa->segmento;
+        ordenar_extensao(buffer, orcamento, ops, tarefa->posicao + inicio * tam, tamanho, -1, NULL);
+    }
+    else {
+        // Cada par usa a regio do pagefile que corresponde  sua posio no arquivo
+        size_t run1_start = passo->indice * 2 * passo->run_size;
+        size_t run1_end = run1_start + passo->run_size - 1;
+        size_t run2_start = run1_end + 1;
+        size_t run2_end = run2_start + passo->run_size - 1;
+        if (run2_end >= n) run2_end = n - 1;
+        merge_runs_improved(buffer, orcamento, ops, tarefa->posicao, run1_start, run1_end, run2_start, run2_end,
+            tarefa->pagefile_pos + run1_start * tam);
+    }
+}
+
+// Devolve a memria do passo e, se ele fechou a fase ou a passada, prepara a prxima. Chamada com a trava
+void terminar_passo(FilaLote* fila, PassoLote* passo) {
+    TarefaOrdenacao* tarefa = &fila->tarefas[passo->tarefa];
+
+    for (size_t p = passo->primeira_pagina; p < passo->primeira_pagina + passo->paginas; p++) {
+        fila->paginas_ocupadas[p] = 0;
+    }
+    fila->paginas_livres += passo->paginas;
+    fila->ociosos++;
+
+    // Os trabalhadores parados podem ter memria ou passos novos agora; sem tarefas restantes, eles saem
+    WakeAllConditionVariable(&fila->mudou);
+
+    tarefa->em_andamento--;
+    if (tarefa->proximo < tarefa->num_passos || tarefa->em_andamento > 0) return;
+
+    tarefa->run_size = tarefa->fase == FASE_RUNS ? tarefa->segmento : tarefa->run_size * 2;
+    if (tarefa->run_size >= tarefa->num_elementos) {
+        tarefa->fase = FASE_CONCLUIDA;
+        fila->concluidas++;
+        double duracao = (double)(clock() - tarefa->inicio) / CLOCKS_PER_SEC * 1000.0;
+        printf("  '%s' ordenado em %.2f ms\n", tarefa->nome, duracao);
+        return;
+    }
+
+    // Pares da nova passada: um run s no fim j est no lugar
+    tarefa->fase = FASE_MESCLAGEM;
+    tarefa->proximo = 0;
+    tarefa->num_passos = (tarefa->num_elementos + tarefa->run_size - 1) / (2 * tarefa->run_size);
+}
+
+DWORD WINAPI trabalhador_lote(LPVOID parametro) {
+    FilaLote* fila = (FilaLote*)parametro;
+
+    while (1) {
+        PassoLote passo;
+
+        // Sem passo possvel, espera o fim de uma passada ou memria livre; algum passo em andamento
+        // vai liberar os dois e acordar os trabalhadores em terminar_passo
+        EnterCriticalSection(&fila->trava);
+        while (fila->concluidas < fila->num_tarefas && !proximo_passo(fila, &passo)) {
+            SleepConditionVariableCS(&fila->mudou, &fila->trava, INFINITE);
+        }
+        int fim = fila->concluidas == fila->num_tarefas;
+        LeaveCriticalSection(&fila->trava);
+
+        if (fim) break;
+
+        executar_passo(fila, &passo);
+
+        EnterCriticalSection(&fila->trava);
+        terminar_passo(fila, &passo);
+        LeaveCriticalSection(&fila->trava);
+    }
+
+    return 0;
+}
+
+int comparar_tarefas(const void* a, const void* b) {
+    size_t na = ((const TarefaOrdenacao*)a)->tamanho;
+    size_t nb = ((const TarefaOrdenacao*)b)->tamanho;
+    return (na < nb) - (na > nb); // Decrescente
+}
+
+void ordenar_lote(int n, char (*nomes)[MAX_FILENAME_LENGTH]) {
+    clock_t start_time = clock();
+
+    if (n <= 0) {
+        printf("Erro: Nenhum arquivo informado\n");
+        return;
+    }
+
+    TarefaOrdenacao* tarefas = calloc(n, sizeof(TarefaOrdenacao));
+    if (!tarefas) {
+        printf("Erro: Falha ao alocar memria\n");
+        return;
+    }
+
+    int num_tarefas = 0;
+    size_t necessario = 0; // Memria para ter todos os arquivos inteiros em memria ao mesmo tempo
+    for (int i = 0; i < n; i++) {
+        int repetido = 0;
+        for (int j = 0; j < i; j++) {
+            if (strcmp(nomes[i], nomes[j]) == 0) repetido = 1;
+        }
+        if (repetido) continue;
+
+        Arquivo* arquivo = find(nomes[i]);
+        if (!arquivo) {
+            printf("Erro: Arquivo '%s' no encontrado\n", nomes[i]);
+            continue;
+        }
+        if (!garantir_exclusivo(arquivo)) continue;
+
+        TarefaOrdenacao* tarefa = &tarefas[num_tarefas++];
+        strncpy(tarefa->nome, arquivo->nome, MAX_FILENAME_LENGTH);
+        tarefa->posicao = arquivo->posicao;
+        tarefa->tamanho = arquivo->tamanho;
+        tarefa->tipo = operacoes(arquivo) - tipos;
+        tarefa->pagefile_pos = -1;
+        tarefa->num_elementos = arquivo->tamanho / tipos[tarefa->tipo].tamanho;
+        necessario += (arquivo->tamanho + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE;
+    }
+
+    if (num_tarefas == 0) {
+        free(tarefas);
+        return;
+    }
+
+    // Maiores primeiro: os passos deles so despachados antes, e o lote no termina esperando por um deles
+    qsort(tarefas, num_tarefas, sizeof(TarefaOrdenacao), comparar_tarefas);
+
+    // Arena do oramento global, em pginas; nunca maior do que o lote precisa nem menor do que uma pgina.
+    // Ela tambm limita o tamanho das transferncias, ento divide a banda de E/S da mesma forma
+    size_t orcamento_total = orcamento_ordenacao_padrao ? orcamento_ordenacao_padrao : orcamento_automatico();
+    size_t num_paginas = orcamento_total / LARGE_PAGE_SIZE;
+    if (num_paginas > necessario) num_paginas = necessario;
+    if (num_paginas < 1) num_paginas = 1;
+
+    // Cada trabalhador precisa de pelo menos uma pgina, ento o oramento limita o nmero de trabalhadores
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int num_trabalhadores = (int)info.dwNumberOfProcessors;
+    if (num_trabalhadores > LOTE_MAX_TRABALHADORES) num_trabalhadores = LOTE_MAX_TRABALHADORES;
+    if ((size_t)num_trabalhadores > num_paginas) num_trabalhadores = (int)num_paginas;
+    if (num_trabalhadores < 1) num_trabalhadores = 1;
+
+    // Runs de uma fatia do oramento por trabalhador, para que a gerao de runs ocupe todos eles.
+    // Cada ordenao externa ganha um pagefile prprio, com um nome que no esteja em uso
+    size_t paginas_trabalhador = num_paginas / num_trabalhadores;
+    int aceitas = 0;
+    int proximo_pagefile = 0;
+    for (int t = 0; t < num_tarefas; t++) {
+        TarefaOrdenacao tarefa = tarefas[t];
+        size_t tam = tipos[tarefa.tipo].tamanho;
+
+        tarefa.paginas_segmento = (tarefa.tamanho + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE;
+        if (tarefa.paginas_segmento > paginas_trabalhador) tarefa.paginas_segmento = paginas_trabalhador;
+        if (tarefa.paginas_segmento < 1) tarefa.paginas_segmento = 1;
+        tarefa.segmento = tarefa.paginas_segmento * LARGE_PAGE_SIZE / tam;
+        tarefa.num_passos = (tarefa.num_elementos + tarefa.segmento - 1) / tarefa.segmento;
+        tarefa.fase = tarefa.num_passos > 0 ? FASE_RUNS : FASE_CONCLUIDA; // Arquivo vazio: nada a fazer
+
+        if (tarefa.num_passos > 1) {
+            do {
+                snprintf(tarefa.pagefile, MAX_FILENAME_LENGTH, "pagefile.%d", proximo_pagefile++);
+            } while (find(tarefa.pagefile) != NULL);
+
+            tarefa.pagefile_pos = criar_pagefile(tarefa.pagefile, tarefa.tamanho);
+            if (tarefa.pagefile_pos == -1) {
+                printf("Erro: '%s' fica fora do lote\n", tarefa.nome);
+                continue;
+            }
+        }
+        tarefas[aceitas++] = tarefa;
+    }
+    num_tarefas = aceitas;
+
+    FilaLote fila;
+    memset(&fila, 0, sizeof(FilaLote));
+    fila.tarefas = tarefas;
+    fila.num_tarefas = num_tarefas;
+    fila.num_paginas = num_paginas;
+    fila.paginas_livres = num_paginas;
+    fila.ociosos = num_trabalhadores;
+    for (int t = 0; t < num_tarefas; t++) {
+        if (tarefas[t].fase == FASE_CONCLUIDA) fila.concluidas++;
+    }
+
+    // Arena alocada aqui, antes das threads, para que as mensagens da alocao no se misturem
+    fila.arena = num_tarefas > 0 ? allocateLargePages(num_paginas * LARGE_PAGE_SIZE) : NULL;
+    fila.paginas_ocupadas = calloc(num_paginas, 1);
+    if (num_tarefas > 0 && (!fila.arena || !fila.paginas_ocupadas)) {
+        printf("Erro: Falha ao alocar memria para ordenao\n");
+        num_tarefas = 0;
+    }
+
+    if (num_tarefas > 0) {
+        printf("Ordenando %d arquivos com %d trabalhadores (oramento de %zu MB, runs de at %zu MB)\n", num_tarefas,
+            num_trabalhadores, num_paginas * LARGE_PAGE_SIZE / (1024 * 1024), paginas_trabalhador * LARGE_PAGE_SIZE / (1024 * 1024));
+        for (int t = 0; t < num_tarefas; t++) tarefas[t].inicio = clock();
+
+        InitializeCriticalSection(&fila.trava);
+        InitializeConditionVariable(&fila.mudou);
+
+        HANDLE threads[LOTE_MAX_TRABALHADORES];
+        int iniciados = 0;
+        for (int w = 0; w < num_trabalhadores; w++) {
+            threads[iniciados] = CreateThread(NULL, 0, trabalhador_lote, &fila, 0, NULL);
+            if (threads[iniciados] == NULL) break;
+            iniciados++;
+        }
+
+        // Trabalhadores que no puderam ser criados no contam como ociosos;
+        // sem nenhuma thread, a thread principal faz o lote sozinha
+        EnterCriticalSection(&fila.trava);
+        fila.ociosos -= num_trabalhadores - (iniciados > 0 ? iniciados : 1);
+        LeaveCriticalSection(&fila.trava);
+        if (iniciados == 0) trabalhador_lote(&fila);
+
+        WaitForMultipleObjects(iniciados, threads, TRUE, INFINITE);
+        for (int w = 0; w < iniciados; w++) {
+            CloseHandle(threads[w]);
+        }
+
+        DeleteCriticalSection(&fila.trava);
+    }
+
+    freeLargePage(fila.arena);
+    free(fila.paginas_ocupadas);
+
+    // Com os trabalhadores encerrados, o catlogo pode ser alterado de novo
+    for (int t = 0; t < aceitas; t++) {
+        if (tarefas[t].pagefile[0] != '\0') apagar(tarefas[t].pagefile);
+        Arquivo* arquivo = find(tarefas[t].nome);
+        if (arquivo && num_tarefas > 0) arquivo->ordenado = 1;
+    }
+    free(tarefas);
+
+    salvar_estado();
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("Lote de %d arquivos ordenado em %.2f ms.\n", num_tarefas, duration);
+}
+
+// Inverte no lugar os 'n' inteiros a partir de 'posicao', trocando blocos das duas pontas
+void inverter_trecho(void* huge_buffer, size_t orcamento, size_t posicao, size_t n) {
+    int* buffer = (int*)huge_buffer;
+    size_t max_ints_in_memory = orcamento / sizeof(int);
+
+    if (n <= max_ints_in_memory) {
+        ler_disco_direto(buffer, sizeof(int), n, posicao);
+        for (size_t i = 0; i < n / 2; i++) {
+            int tmp = buffer[i]; buffer[i] = buffer[n - 1 - i]; buffer[n - 1 - i] = tmp;
+        }
+        escrever_disco_direto(buffer, sizeof(int), n, posicao);
+        return;
+    }
+
+    // Metade do oramento para cada ponta
+    size_t metade = max_ints_in_memory / 2;
+    int* esquerda = buffer;
+    int* direita = buffer + metade;
+    size_t lo = 0;
+    size_t hi = n;
+
+    while (hi - lo > 1) {
+        size_t k = (hi - lo) / 2 < metade ? (hi - lo) / 2 : metade;
+        ler_disco_direto(esquerda, sizeof(int), k, posicao + lo * sizeof(int));
+        ler_disco_direto(direita, sizeof(int), k, posicao + (hi - k) * sizeof(int));
+        for (size_t i = 0; i < k / 2; i++) {
+            int tmp = esquerda[i]; esquerda[i] = esquerda[k - 1 - i]; esquerda[k - 1 - i] = tmp;
+            tmp = direita[i]; direita[i] = direita[k - 1 - i]; direita[k - 1 - i] = tmp;
+        }
+        escrever_disco_direto(direita, sizeof(int), k, posicao + lo * sizeof(int));
+        escrever_disco_direto(esquerda, sizeof(int), k, posicao + (hi - k) * sizeof(int));
+        lo += k;
+        hi -= k;
+    }
+}
+
+// Acrescenta um trecho natural  lista. Trechos pequenos vizinhos so agrupados at encher a memria
+// (e depois ordenados em memria), o que limita a lista a cerca de 2 * TRECHO_PEQUENO_FRACAO * n / memria
+// entradas. Os grandes ficam como esto e s so mesclados
+int adicionar_trecho(Trecho** trechos, size_t* quantidade, size_t* capacidade,
+    size_t inicio, size_t tamanho, int estado, size_t max_ints_in_memory) {
+    size_t pequeno = max_ints_in_memory / TRECHO_PEQUENO_FRACAO;
+    if (*quantidade > 0 && tamanho < pequeno) {
+        Trecho* ultimo = &(*trechos)[*quantidade - 1];
+        int agrupavel = ultimo->estado == TRECHO_MISTO || ultimo->tamanho < pequeno;
+        if (agrupavel && ultimo->tamanho + tamanho <= max_ints_in_memory) {
+            ultimo->tamanho += tamanho;
+            ultimo->estado = TRECHO_MISTO;
+            return 1;
+        }
+    }
+
+    if (*quantidade == *capacidade) {
+        size_t nova_capacidade = *capacidade ? *capacidade * 2 : 64;
+        Trecho* novos = realloc(*trechos, nova_capacidade * sizeof(Trecho));
+        if (!novos) return 0;
+        *trechos = novos;
+        *capacidade = nova_capacidade;
+    }
+
+    Trecho* trecho = &(*trechos)[(*quantidade)++];
+    trecho->inicio = inicio;
+    trecho->tamanho = tamanho;
+    trecho->estado = estado;
+    return 1;
+}
+
+// Ordenar adaptativo: aproveita a ordem j existente no arquivo.
+// Uma leitura sequencial encontra os trechos crescentes/decrescentes, os decrescentes so invertidos
+// no lugar e s os trechos encontrados so mesclados. Um arquivo j ordenado custa uma nica leitura.
+void ordenar_adaptativo(const char* nome) {
+    clock_t start_time = clock();
+
+    Arquivo* arquivo = find(nome);
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado.\n", nome);
+        return;
+    }
+
+    if (arquivo->ordenado) {
+        printf("Arquivo '%s' j est ordenado.\n", nome);
+        return;
+    }
+
+    if (arquivo->tipo != TIPO_INT32) {
+        printf("Erro: ordenar_adaptativo s aceita arquivos int32; use 'ordenar' para '%s' (%s)\n", nome, operacoes(arquivo)->nome);
+        return;
+    }
+
+    // Verificado antes de mexer no arquivo: a mesclagem dos trechos precisa do pagefile
+    if (ponto_de_controle_ocupado(nome) || !garantir_exclusivo(arquivo)) {
+        return;
+    }
+
+    // O pagefile pode deslocar entradas do catlogo: guardar a extenso do arquivo
+    size_t posicao = arquivo->posicao;
+    size_t tamanho = arquivo->tamanho;
+    size_t num_ints = tamanho / sizeof(int);
+    printf("Ordenando (adaptativo) arquivo '%s' com %zu inteiros (%zu bytes)\n", nome, num_ints, tamanho);
+
+    size_t orcamento = orcamento_efetivo(0, tamanho);
+    void* huge_buffer = allocateLargePages(orcamento);
+    if (!huge_buffer) {
+        printf("Erro: Falha ao alocar memria para ordenao\n");
+        return;
+    }
+
+    int* buffer = (int*)huge_buffer;
+    size_t max_ints_in_memory = orcamento / sizeof(int);
+
+    // 1. Leitura sequencial: detectar os trechos naturais
+    Trecho* trechos = NULL;
+    size_t num_trechos = 0;
+    size_t capacidade = 0;
+    size_t naturais = 0;
+    size_t decrescentes = 0;
+
+    size_t inicio = 0;
+    size_t tamanho_trecho = 0;
+    int direcao = 0; // 0: ainda indefinida (elementos iguais), 1: crescente, -1: decrescente
+    int anterior = 0;
+    int ok = 1;
+    size_t lidos = 0;
+
+    while (ok && lidos < num_ints) {
+        size_t to_read = (num_ints - lidos) < max_ints_in_memory ? (num_ints - lidos) : max_ints_in_memory;
+        size_t read = ler_disco_direto(buffer, sizeof(int), to_read, posicao + lidos * sizeof(int));
+        if (read == 0) break;
+
+        for (size_t i = 0; ok && i < read; i++) {
+            int x = buffer[i];
+            if (tamanho_trecho == 0) {
+                inicio = lidos + i;
+                tamanho_trecho = 1;
+                direcao = 0;
+            }
+            else if (direcao == 0) {
+                direcao = x > anterior ? 1 : (x < anterior ? -1 : 0);
+                tamanho_trecho++;
+            }
+            else if ((direcao > 0 && x >= anterior) || (direcao < 0 && x <= anterior)) {
+                tamanho_trecho++;
+            }
+            else {
+                naturais++;
+                if (direcao < 0) decrescentes++;
+                ok = adicionar_trecho(&trechos, &num_trechos, &capacidade, inicio, tamanho_trecho,
+                    direcao < 0 ? TRECHO_DECRESCENTE : TRECHO_CRESCENTE, max_ints_in_memory);
+                inicio = lidos + i;
+                tamanho_trecho = 1;
+                direcao = 0;
+            }
+            anterior = x;
+        }
+        lidos += read;
+    }
+
+    if (ok && tamanho_trecho > 0) {
+        naturais++;
+        if (direcao < 0) decrescentes++;
+        ok = adicionar_trecho(&trechos, &num_trechos, &capacidade, inicio, tamanho_trecho,
+            direcao < 0 ? TRECHO_DECRESCENTE : TRECHO_CRESCENTE, max_ints_in_memory);
+    }
+
+    if (!ok) {
+        printf("Erro: Falha ao alocar memria para a lista de trechos\n");
+        free(trechos);
+        freeLargePage(huge_buffer);
+        return;
+    }
+
+    printf("Trechos naturais: %zu (%zu decrescentes); %zu aps agrupar os pequenos\n",
+        naturais, decrescentes, num_trechos);
+
+    // 2. Inverter os trechos decrescentes e ordenar em memria os agrupados
+    for (size_t t = 0; t < num_trechos; t++) {
+        Trecho* trecho = &trechos[t];
+        size_t trecho_pos = posicao + trecho->inicio * sizeof(int);
+
+        if (trecho->estado == TRECHO_DECRESCENTE) {
+            inverter_trecho(huge_buffer, orcamento, trecho_pos, trecho->tamanho);
+        }
+        else if (trecho->estado == TRECHO_MISTO) {
+            ler_disco_direto(buffer, sizeof(int), trecho->tamanho, trecho_pos);
+            tipos[TIPO_INT32].ordenar(buffer, trecho->tamanho);
+            escrever_disco_direto(buffer, sizeof(int), trecho->tamanho, trecho_pos);
+        }
+        trecho->estado = TRECHO_CRESCENTE;
+    }
+    fflush(disco_virtual);
+
+    // 3. Mesclar os trechos dois a dois at sobrar um
+    if (num_trechos > 1) {
+        size_t pagefile_pos = criar_pagefile("pagefile", tamanho);
+        if (pagefile_pos == -1) {
+            free(trechos);
+            freeLargePage(huge_buffer);
+            return;
+        }
+
+        while (num_trechos > 1) {
+            size_t restantes = 0;
+            for (size_t t = 0; t < num_trechos; t += 2) {
+                Trecho combinado = trechos[t];
+                if (t + 1 < num_trechos) {
+                    Trecho* segundo = &trechos[t + 1];
+                    merge_runs_improved(huge_buffer, orcamento, &tipos[TIPO_INT32], posicao,
+                        combinado.inicio, combinado.inicio + combinado.tamanho - 1,
+                        segundo->inicio, segundo->inicio + segundo->tamanho - 1, pagefile_pos);
+                    combinado.tamanho += segundo->tamanho;
+                }
+                trechos[restantes++] = combinado;
+            }
+            num_trechos = restantes;
+        }
+
+        apagar("pagefile");
+    }
+
+    free(trechos);
+    freeLargePage(huge_buffer);
+
+    arquivo = find(nome);
+    if (arquivo) arquivo->ordenado = 1;
+
+    salvar_estado();
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+
+    printf("Arquivo '%s' ordenado em %.2f ms.\n", nome, duration);
+}
+
+// Verifica com uma leitura sequencial se o arquivo est em ordem crescente
+int esta_ordenado(Arquivo* arquivo, void* huge_buffer) {
+    const OperacoesTipo* ops = operacoes(arquivo);
+    size_t max_in_memory = LARGE_PAGE_SIZE / ops->tamanho;
+    size_t num_elementos = arquivo->tamanho / ops->tamanho;
+    size_t lidos = 0;
+
+    // Cada leitura repete o ltimo elemento da anterior, para comparar tambm a fronteira entre elas
+    while (lidos < num_elementos) {
+        size_t inicio = lidos > 0 ? lidos - 1 : 0;
+        size_t to_read = (num_elementos - inicio) < max_in_memory ? (num_elementos - inicio) : max_in_memory;
+        size_t read = ler_disco(huge_buffer, ops->tamanho, to_read, arquivo->posicao + inicio * ops->tamanho);
+        if (read == 0) break;
+
+        if (!ops->em_ordem(huge_buffer, read)) return 0;
+        lidos = inicio + read;
+    }
+
+    return 1;
+}
+
+// Mesclar: intercala dois arquivos j ordenados em um novo arquivo, em uma nica passada
+void mesclar(const char* nome1, const char* nome2, const char* destino) {
+    clock_t start_time = clock();
+
+    Arquivo* arquivo1 = find(nome1);
+    Arquivo* arquivo2 = find(nome2);
+
+    if (arquivo1 == NULL || arquivo2 == NULL) {
+        printf("Erro: Um dos arquivos no foi encontrado\n");
+        return;
+    }
+
+    if (arquivo1 == arquivo2) {
+        printf("Erro: Os arquivos a mesclar devem ser diferentes\n");
+        return;
+    }
+
+    if (arquivo1->tipo != arquivo2->tipo) {
+        printf("Erro: '%s'  %s e '%s'  %s\n", nome1, operacoes(arquivo1)->nome, nome2, operacoes(arquivo2)->nome);
+        return;
+    }
+    const OperacoesTipo* ops = operacoes(arquivo1);
+
+    size_t orcamento = orcamento_efetivo(0, arquivo1->tamanho + arquivo2->tamanho);
+    void* huge_buffer = allocateLargePages(orcamento);
+    if (!huge_buffer) {
+        printf("Erro: Falha ao alocar memria para mesclagem\n");
+        return;
+    }
+
+    // Confia na marca de ordenao; sem ela, verifica o contedo antes de mesclar
+    Arquivo* entradas[2] = { arquivo1, arquivo2 };
+    for (int i = 0; i < 2; i++) {
+        if (entradas[i]->ordenado) continue;
+        if (!esta_ordenado(entradas[i], huge_buffer)) {
+            printf("Erro: Arquivo '%s' no est ordenado. Use 'ordenar' antes de mesclar.\n", entradas[i]->nome);
+            freeLargePage(huge_buffer);
+            return;
+        }
+        entradas[i]->ordenado = 1;
+    }
+
+    // Novas entradas so adicionadas ao fim do catlogo, ento arquivo1 e arquivo2 continuam vlidos
+    Arquivo* saida = alocar_arquivo(destino, arquivo1->tamanho + arquivo2->tamanho);
+    if (!saida) {
+        freeLargePage(huge_buffer);
+        return;
+    }
+
+    intercalar_sequencias(huge_buffer, orcamento, ops, arquivo1->posicao, arquivo1->tamanho / ops->tamanho,
+        arquivo2->posicao, arquivo2->tamanho / ops->tamanho, saida->posicao);
+    saida->ordenado = 1;
+    saida->tipo = arquivo1->tipo;
+
+    freeLargePage(huge_buffer);
+
+    // Liberar as entradas originais
+    apagar(nome1);
+    apagar(nome2);
+
+    salvar_estado();
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+
+    printf("Arquivos '%s' e '%s' mesclados em '%s' em %.2f ms\n", nome1, nome2, destino, duration);
+}
+
+// Maiores/Menores: exibe os k maiores (ou menores) valores em uma nica leitura, sem alterar o arquivo
+void top_k(const char* nome, int k, int maiores) {
+    clock_t start_time = clock();
+
+    Arquivo* arquivo = find(nome);
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado.\n", nome);
+        return;
+    }
+
+    const OperacoesTipo* ops = operacoes(arquivo);
+    size_t num_elementos = arquivo->tamanho / ops->tamanho;
+    if (k <= 0) {
+        printf("Erro: k deve ser positivo\n");
+        return;
+    }
+    size_t limite = (size_t)k < num_elementos ? (size_t)k : num_elementos;
+
+    void* heap = malloc(limite * ops->tamanho + 1);
+    if (!heap) {
+        printf("Erro: Falha ao alocar memria\n");
+        return;
+    }
+    size_t heap_size = 0;
+
+    if (arquivo->ordenado) {
+        // Arquivo ordenado: os resultados esto nas extremidades
+        size_t inicio = maiores ? num_elementos - limite : 0;
+        heap_size = ler_disco(heap, ops->tamanho, limite, arquivo->posicao + inicio * ops->tamanho);
+        if (maiores) inverter_elementos(heap, heap_size, ops->tamanho);
+    }
+    else {
+        void* huge_buffer = allocateLargePage();
+        if (!huge_buffer) {
+            printf("Erro: Falha ao alocar memria\n");
+            free(heap);
+            return;
+        }
+
+        size_t max_in_memory = LARGE_PAGE_SIZE / ops->tamanho;
+        size_t lidos = 0;
+
+        while (lidos < num_elementos) {
+            size_t to_read = (num_elementos - lidos) < max_in_memory ? (num_elementos - lidos) : max_in_memory;
+            size_t read = ler_disco(huge_buffer, ops->tamanho, to_read, arquivo->posicao + lidos * ops->tamanho);
+            if (read == 0) break;
+
+            ops->selecionar(huge_buffer, read, heap, &heap_size, limite, maiores);
+            lidos += read;
+        }
+
+        freeLargePage(huge_buffer);
+
+        ops->esvaziar_heap(heap, heap_size, maiores);
+    }
+
+    printf("%zu %s valores do arquivo '%s':\n", heap_size, maiores ? "maiores" : "menores", nome);
+    ops->imprimir(heap, heap_size);
+    printf("\n");
+
+    free(heap);
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("Consulta concluda em %.2f ms\n", duration);
+}
+
+// Chave de 'distintos': o valor como uint32, na ordem do tipo (o int32 tem o bit de sinal invertido)
+unsigned int chave_distintos(int valor, int sem_sinal) {
+    return (unsigned int)valor ^ (sem_sinal ? 0u : 0x80000000u);
+}
+
+// Grava o buffer de uma partio no prximo pedao livre do pagefile
+void gravar_pedaco_distintos(ColetaDistintos* coleta, int particao) {
+    size_t pedaco = coleta->num_pedacos++;
+    escrever_disco_direto(coleta->particoes + (size_t)particao * DISTINTOS_PEDACO, sizeof(unsigned int),
+        coleta->na_particao[particao], coleta->pagefile_pos + pedaco * DISTINTOS_PEDACO * sizeof(unsigned int));
+    coleta->pedacos_usados[pedaco] = (unsigned int)coleta->na_particao[particao];
+    coleta->pedacos_particao[pedaco] = (unsigned char)particao;
+    coleta->na_particao[particao] = 0;
+}
+
+// Depois do transbordo: acrescenta a chave (repetida ou no)  partio da sua faixa
+void espalhar_distinto(ColetaDistintos* coleta, unsigned int chave) {
+    int particao = (int)(chave / (BITMAP_DISTINTOS_BYTES * 8ULL));
+    coleta->particoes[(size_t)particao * DISTINTOS_PEDACO + coleta->na_particao[particao]++] = chave;
+    if (coleta->na_particao[particao] == DISTINTOS_PEDACO) gravar_pedaco_distintos(coleta, particao);
+}
+
+// O conjunto hash encheu: cria o pagefile e passa para as parties as chaves j guardadas.
+// O pagefile comporta todos os valores do arquivo, mais um pedao incompleto por partio
+int transbordar_distintos(ColetaDistintos* coleta, size_t num_ints) {
+    size_t max_pedacos = (num_ints + DISTINTOS_PEDACO - 1) / DISTINTOS_PEDACO + DISTINTOS_PARTICOES;
+    coleta->particoes = alocar_alinhado((size_t)DISTINTOS_PARTICOES * DISTINTOS_PEDACO * sizeof(unsigned int));
+    coleta->pedacos_usados = malloc(max_pedacos * sizeof(unsigned int));
+    coleta->pedacos_particao = malloc(max_pedacos);
+    if (!coleta->particoes || !coleta->pedacos_usados || !coleta->pedacos_particao) {
+        printf("Erro: Falha ao alocar memria\n");
+        return 0;
+    }
+
+    int numero = 0;
+    do {
+        snprintf(coleta->pagefile, MAX_FILENAME_LENGTH, "pagefile.%d", numero++);
+    } while (find(coleta->pagefile) != NULL);
+
+    coleta->pagefile_pos = criar_pagefile(coleta->pagefile, max_pedacos * DISTINTOS_PEDACO * sizeof(unsigned int));
+    if (coleta->pagefile_pos == -1) return 0;
+    coleta->transbordou = 1;
+
+    for (size_t slot = 0; slot < HASH_DISTINTOS_CAPACIDADE; slot++) {
+        if (coleta->ocupado[slot]) espalhar_distinto(coleta, coleta->chaves[slot]);
+    }
+    free(coleta->chaves);
+    free(coleta->ocupado);
+    coleta->chaves = NULL;
+    coleta->ocupado = NULL;
+    return 1;
+}
+
+// L o arquivo uma nica vez e junta suas chaves distintas, alm da faixa e do nmero de trocas entre
+// vizinhos (que j  a contagem quando o arquivo est ordenado; com 'so_vizinhos' nada mais  guardado).
+// As chaves ficam em um conjunto hash at metade da capacidade; depois disso todas as chaves seguintes vo,
+// com repeties, para parties no pagefile, uma para cada faixa coberta pelo bitmap de BITMAP_DISTINTOS_BYTES.
+// Retorna 0 em caso de erro (j informado)
+int coletar_distintos(Arquivo* arquivo, int* buffer, int sem_sinal, int so_vizinhos, ColetaDistintos* coleta) {
+    size_t max_ints_in_memory = LARGE_PAGE_SIZE / sizeof(int);
+    size_t num_ints = arquivo->tamanho / sizeof(int);
+    size_t capacidade = HASH_DISTINTOS_CAPACIDADE;
+    size_t lidos = 0;
+    unsigned int anterior = 0;
+
+    memset(coleta, 0, sizeof(*coleta));
+    if (!so_vizinhos) {
+        coleta->chaves = malloc(capacidade * sizeof(unsigned int));
+        coleta->ocupado = calloc(capacidade, 1);
+        if (!coleta->chaves || !coleta->ocupado) {
+            printf("Erro: Falha ao alocar memria\n");
+            return 0;
+        }
+    }
+
+    while (lidos < num_ints) {
+        size_t to_read = (num_ints - lidos) < max_ints_in_memory ? (num_ints - lidos) : max_ints_in_memory;
+        size_t read = ler_disco(buffer, sizeof(int), to_read, arquivo->posicao + lidos * sizeof(int));
+        if (read == 0) break;
+
+        for (size_t i = 0; i < read; i++) {
+            unsigned int chave = chave_distintos(buffer[i], sem_sinal);
+            if (lidos == 0 && i == 0) {
+                coleta->menor = coleta->maior = chave;
+                coleta->vizinhos = 1;
+            }
+            else {
+                if (chave < coleta->menor) coleta->menor = chave;
+                if (chave > coleta->maior) coleta->maior = chave;
+                if (chave != anterior) coleta->vizinhos++;
+            }
+            anterior = chave;
+
+            if (so_vizinhos) continue;
+            if (coleta->transbordou) {
+                espalhar_distinto(coleta, chave);
+                continue;
+            }
+
+            size_t slot = (chave * 2654435761u) & (capacidade - 1);
+            while (coleta->ocupado[slot] && coleta->chaves[slot] != chave) {
+                slot = (slot + 1) & (capacidade - 1);
+            }
+            if (coleta->ocupado[slot]) continue;
+
+            // Mantm o fator de carga abaixo de 50%
+            if (coleta->quantidade >= capacidade / 2) {
+                if (!transbordar_distintos(coleta, num_ints)) return 0;
+                espalhar_distinto(coleta, chave);
+                continue;
+            }
+            coleta->ocupado[slot] = 1;
+            coleta->chaves[slot] = chave;
+            coleta->quantidade++;
+        }
+        lidos += read;
+    }
+
+    if (coleta->transbordou) {
+        for (int p = 0; p < DISTINTOS_PARTICOES; p++) {
+            if (coleta->na_particao[p] > 0) gravar_pedaco_distintos(coleta, p);
+        }
+        liberar_alinhado(coleta->particoes);
+        coleta->particoes = NULL;
+    }
+    else if (!so_vizinhos) {
+        // Junta as chaves no incio do vetor, para quem precisar delas em ordem
+        size_t juntas = 0;
+        for (size_t slot = 0; slot < capacidade; slot++) {
+            if (coleta->ocupado[slot]) coleta->chaves[juntas++] = coleta->chaves[slot];
+        }
+    }
+    return 1;
+}
+
+// Marca no bitmap as chaves gravadas em uma partio do pagefile e retorna quantas so distintas.
+// Uma partio sem pedaos no toca no bitmap
+size_t marcar_particao_distintos(ColetaDistintos* coleta, int particao, unsigned char* bitmap, int* buffer) {
+    size_t distintos = 0;
+    int limpo = 0;
+
+    for (size_t pedaco = 0; pedaco < coleta->num_pedacos; pedaco++) {
+        if (coleta->pedacos_particao[pedaco] != particao) continue;
+        if (!limpo) {
+            memset(bitmap, 0, BITMAP_DISTINTOS_BYTES);
+            limpo = 1;
+        }
+
+        unsigned int* chaves = (unsigned int*)buffer;
+        size_t usados = coleta->pedacos_usados[pedaco];
+        ler_disco_direto(chaves, sizeof(unsigned int), usados, coleta->pagefile_pos + pedaco * DISTINTOS_PEDACO * sizeof(unsigned int));
+        for (size_t i = 0; i < usados; i++) {
+            size_t deslocamento = chaves[i] % (BITMAP_DISTINTOS_BYTES * 8ULL);
+            unsigned char mascara = 1 << (deslocamento % 8);
+            if (!(bitmap[deslocamento / 8] & mascara)) {
+                bitmap[deslocamento / 8] |= mascara;
+                distintos++;
+            }
+        }
+    }
+    return distintos;
+}
+
+// Libera a memria da coleta e apaga o pagefile do transbordo
+void liberar_coleta_distintos(ColetaDistintos* coleta) {
+    free(coleta->chaves);
+    free(coleta->ocupado);
+    liberar_alinhado(coleta->particoes);
+    free(coleta->pedacos_usados);
+    free(coleta->pedacos_particao);
+    if (coleta->pagefile[0] != '\0' && find(coleta->pagefile) != NULL) apagar(coleta->pagefile);
+    memset(coleta, 0, sizeof(*coleta));
+}
+
+// Distintos: conta os valores distintos do arquivo sem orden-lo nem alter-lo
+void distintos(const char* nome) {
+    clock_t start_time = clock();
+
+    Arquivo* arquivo = find(nome);
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado.\n", nome);
+        return;
+    }
+
+    if (arquivo->tipo != TIPO_INT32 && arquivo->tipo != TIPO_UINT32) {
+        printf("Erro: distintos s aceita arquivos int32 ou uint32 ('%s'  %s)\n", nome, operacoes(arquivo)->nome);
+        return;
+    }
+
+    if (arquivo->tamanho / sizeof(int) == 0) {
+        printf("Arquivo '%s' possui 0 valores distintos\n", nome);
+        return;
+    }
+
+    void* huge_buffer = allocateLargePage();
+    if (!huge_buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        return;
+    }
+
+    // Um arquivo ordenado  contado pelas trocas entre vizinhos, sem conjunto
+    int sem_sinal = arquivo->tipo == TIPO_UINT32;
+    int ordenado = arquivo->ordenado;
+    ColetaDistintos coleta;
+    if (!coletar_distintos(arquivo, (int*)huge_buffer, sem_sinal, ordenado, &coleta)) {
+        liberar_coleta_distintos(&coleta);
+        freeLargePage(huge_buffer);
+        return;
+    }
+
+    size_t quantidade = ordenado ? coleta.vizinhos : coleta.quantidade;
+    if (coleta.transbordou) {
+        // Segunda leitura, s do pagefile: uma partio de cada vez no bitmap
+        unsigned char* bitmap = malloc(BITMAP_DISTINTOS_BYTES);
+        if (!bitmap) {
+            printf("Erro: Falha ao alocar memria\n");
+            liberar_coleta_distintos(&coleta);
+            freeLargePage(huge_buffer);
+            return;
+        }
+
+        quantidade = 0;
+        for (int p = 0; p < DISTINTOS_PARTICOES; p++) {
+            quantidade += marcar_particao_distintos(&coleta, p, bitmap, (int*)huge_buffer);
+        }
+        free(bitmap);
+        printf("Muitos valores distintos: contagem feita pelas parties de '%s'\n", coleta.pagefile);
+    }
+
+    unsigned int menor = coleta.menor, maior = coleta.maior;
+    liberar_coleta_distintos(&coleta);
+    freeLargePage(huge_buffer);
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+
+    if (sem_sinal) {
+        printf("Arquivo '%s' possui %zu valores distintos (entre %u e %u), contados em %.2f ms\n",
+            nome, quantidade, menor, maior, duration);
+    }
+    else {
+        printf("Arquivo '%s' possui %zu valores distintos (entre %d e %d), contados em %.2f ms\n",
+            nome, quantidade, (int)chave_distintos((int)menor, 0), (int)chave_distintos((int)maior, 0), duration);
+    }
+}
+
+// Grava os valores pendentes no buffer de sada de distintos_valores
+void descarregar_distintos(int* buffer, size_t* pendentes, size_t* escritos, size_t posicao_saida) {
+    if (*pendentes == 0) return;
+    escrever_disco_direto(buffer, sizeof(int), *pendentes, posicao_saida + *escritos * sizeof(int));
+    *escritos += *pendentes;
+    *pendentes = 0;
+}
+
+// Distintos (valores): grava em 'destino' os valores distintos do arquivo, em ordem crescente.
+// O arquivo  lido uma vez. Sem transbordo, as chaves do conjunto hash so ordenadas em memria; com ele,
+// cada partio do pagefile  marcada no bitmap e os bits marcados j saem em ordem. O destino 
+// reservado com o tamanho da origem e encolhido no fim para os valores gravados
+void distintos_valores(const char* nome, const char* destino) {
+    clock_t start_time = clock();
+
+    Arquivo* arquivo = find(nome);
+    if (!arquivo) {
+        printf("Erro: Arquivo '%s' no encontrado.\n", nome);
+        return;
+    }
+
+    if (arquivo->tipo != TIPO_INT32 && arquivo->tipo != TIPO_UINT32) {
+        printf("Erro: distintos s aceita arquivos int32 ou uint32 ('%s'  %s)\n", nome, operacoes(arquivo)->nome);
+        return;
+    }
+
+    if (arquivo->tamanho / sizeof(int) == 0) {
+        printf("Erro: Arquivo '%s' no possui valores\n", nome);
+        return;
+    }
+
+    void* huge_buffer = allocateLargePage();
+    if (!huge_buffer) {
+        printf("Erro: Falha ao alocar memria\n");
+        return;
+    }
+
+    int sem_sinal = arquivo->tipo == TIPO_UINT32;
+    int* buffer = (int*)huge_buffer;
+    size_t max_ints_in_memory = LARGE_PAGE_SIZE / sizeof(int);
+    ColetaDistintos coleta;
+    if (!coletar_distintos(arquivo, buffer, sem_sinal, 0, &coleta)) {
+        liberar_coleta_distintos(&coleta);
+        freeLargePage(huge_buffer);
+        return;
+    }
+
+    unsigned char* bitmap = coleta.transbordou ? malloc(BITMAP_DISTINTOS_BYTES) : NULL;
+    if (coleta.transbordou && !bitmap) {
+        printf("Erro: Falha ao alocar memria\n");
+        liberar_coleta_distintos(&coleta);
+        freeLargePage(huge_buffer);
+        return;
+    }
+
+    // Novas entradas so adicionadas ao fim do catlogo, ento 'arquivo' continua vlido
+    int tipo = arquivo->tipo;
+    Arquivo* saida = alocar_arquivo(destino, arquivo->tamanho);
+    if (!saida) {
+        free(bitmap);
+        liberar_coleta_distintos(&coleta);
+        freeLargePage(huge_buffer);
+        return;
+    }
+    saida->tipo = tipo;
+    size_t posicao_saida = saida->posicao;
+
+    size_t escritos = 0;
+    size_t pendentes = 0;
+    if (!coleta.transbordou) {
+        tipos[TIPO_UINT32].ordenar(coleta.chaves, coleta.quantidade);
+        for (size_t i = 0; i < coleta.quantidade; i++) {
+            buffer[pendentes++] = (int)chave_distintos((int)coleta.chaves[i], sem_sinal);
+            if (pendentes == max_ints_in_memory) descarregar_distintos(buffer, &pendentes, &escritos, posicao_saida);
+        }
+    }
+    else {
+        // O buffer l os pedaos enquanto a partio  marcada e depois junta os valores dela para a gravao
+        for (int p = 0; p < DISTINTOS_PARTICOES; p++) {
+            if (marcar_particao_distintos(&coleta, p, bitmap, buffer) == 0) continue;
+
+            unsigned int base = (unsigned int)p * (unsigned int)(BITMAP_DISTINTOS_BYTES * 8ULL);
+            for (size_t byte = 0; byte < BITMAP_DISTINTOS_BYTES; byte++) {
+                if (bitmap[byte] == 0) continue;
+                for (int bit = 0; bit < 8; bit++) {
+                    if (!(bitmap[byte] & (1 << bit))) continue;
+                    buffer[pendentes++] = (int)chave_distintos((int)(base + (unsigned int)(byte * 8 + bit)), sem_sinal);
+                    if (pendentes == max_ints_in_memory) descarregar_distintos(buffer, &pendentes, &escritos, posicao_saida);
+                }
+            }
+
+            // A prxima partio l o pagefile no mesmo buffer
+            descarregar_distintos(buffer, &pendentes, &escritos, posicao_saida);
+        }
+    }
+    descarregar_distintos(buffer, &pendentes, &escritos, posicao_saida);
+    descarregar_disco();
+
+    free(bitmap);
+    liberar_coleta_distintos(&coleta);
+    freeLargePage(huge_buffer);
+
+    // Devolver os blocos que sobraram depois do ltimo valor (o pagefile apagado pode ter deslocado a entrada)
+    saida = find(destino);
+    size_t blocos_reservados = saida->tamanho / BLOCK_SIZE + (saida->tamanho % BLOCK_SIZE != 0);
+    size_t blocos_usados = (escritos * sizeof(int) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    for (size_t b = blocos_usados; b < blocos_reservados; b++) {
+        marcar_bloco_livre(saida->posicao / BLOCK_SIZE + b);
+    }
+    sa.espaco_livre += saida->tamanho - escritos * sizeof(int);
+    saida->tamanho = escritos * sizeof(int);
+    saida->ordenado = 1;
+
+    salvar_estado();
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("%zu valores distintos de '%s' gravados em '%s' em %.2f ms\n", escritos, nome, destino, duration);
+}
+
+// Simulador de envelhecimento
+// Gera (ou reproduz) uma sequncia de criar/apagar/concatenar/ordenar contra uma imagem de rascunho e,
+// depois de cada operao, registra a latncia, o tempo gasto no alocador, a maior extenso livre e o
+// ndice de fragmentao (1 - maior extenso livre / espao livre). O trace gerado usa a mesma sintaxe
+// dos comandos, ento pode ser reproduzido com outra poltica de alocao para comparar as duas.
+// O disco real, o catlogo, o cache e o ponto de controle so guardados antes e restaurados no fim.
+
+unsigned long long estado_simulacao = 1;
+
+// xorshift64*: sequncia prpria, para que o trace no dependa de quantas vezes rand() foi chamado
+unsigned long long aleatorio_simulacao() {
+    estado_simulacao ^= estado_simulacao >> 12;
+    estado_simulacao ^= estado_simulacao << 25;
+    estado_simulacao ^= estado_simulacao >> 27;
+    return estado_simulacao * 2685821657736338717ULL;
+}
+
+size_t sortear_tamanho() {
+    ConfiguracaoSimulacao* config = &config_simulacao;
+    double u = (double)(aleatorio_simulacao() >> 11) / (double)(1ULL << 53);
+
+    if (config->logaritmica) {
+        double minimo = log((double)config->tamanho_min);
+        double maximo = log((double)config->tamanho_max);
+        return (size_t)exp(minimo + u * (maximo - minimo));
+    }
+    return config->tamanho_min + (size_t)(u * (double)(config->tamanho_max - config->tamanho_min));
+}
+
+EstadoEspaco medir_espaco() {
+    EstadoEspaco estado = { 0 };
+    size_t atual = 0;
+
+    for (size_t i = 0; i < NUM_BLOCOS_DADOS; i++) {
+        // Bytes inteiramente ocupados so pulados de uma vez
+        if (i % 8 == 0 && i + 8 <= NUM_BLOCOS_DADOS && sa.bitmap[i / 8] == 0xFF) {
+            atual = 0;
+            i += 7;
+            continue;
+        }
+
+        if (bloco_esta_livre(i)) {
+            if (atual == 0) estado.extensoes_livres++;
+            atual++;
+            estado.blocos_livres++;
+            if (atual > estado.maior_extensao) estado.maior_extensao = atual;
+        }
+        else {
+            atual = 0;
+        }
+    }
+
+    return estado;
+}
+
+double indice_fragmentacao(EstadoEspaco* estado) {
+    if (estado->blocos_livres == 0) return 0.0;
+    return 1.0 - (double)estado->maior_extensao / (double)estado->blocos_livres;
+}
+
+// Um arquivo do catlogo ao acaso, ou NULL se no houver
+Arquivo* sortear_arquivo() {
+    if (sa.quantidade_arquivos == 0) return NULL;
+    return &sa.arquivos[aleatorio_simulacao() % sa.quantidade_arquivos];
+}
+
+// Escolhe a prxima operao a partir do estado atual da imagem e a escreve como linha de comando
+void gerar_operacao(char* linha, size_t tamanho_linha, size_t* contador_nomes) {
+    double ocupacao = 1.0 - (double)sa.espaco_livre / (double)(DISK_SIZE - META_DATA_SIZE);
+    int peso_criar = ocupacao > SIMULACAO_OCUPACAO_ALVO ? 25 : 50;
+    int peso_apagar = ocupacao > SIMULACAO_OCUPACAO_ALVO ? 55 : 30;
+    int sorteio = (int)(aleatorio_simulacao() % 100);
+
+    Arquivo* arquivo = sortear_arquivo();
+    if (!arquivo || sorteio < peso_criar) {
+        size_t elementos = sortear_tamanho() / sizeof(int);
+        snprintf(linha, tamanho_linha, "criar s%zu %zu", (*contador_nomes)++, elementos > 0 ? elementos : 1);
+    }
+    else if (sorteio < peso_criar + peso_apagar) {
+        snprintf(linha, tamanho_linha, "apagar %s", arquivo->nome);
+    }
+    else if (sorteio < peso_criar + peso_apagar + 10 && sa.quantidade_arquivos > 1) {
+        Arquivo* outro = sortear_arquivo();
+        while (outro == arquivo) outro = sortear_arquivo();
+        snprintf(linha, tamanho_linha, "concatenar %s %s", arquivo->nome, outro->nome);
+    }
+    else {
+        snprintf(linha, tamanho_linha, "ordenar %s", arquivo->nome);
+    }
+}
+
+// Executa uma linha do trace. Os comandos s imprimem os erros, ento o sucesso  conferido no catlogo.
+// Retorna a operao (SIM_*), ou -1 se a linha no for reconhecida
+int executar_operacao_simulada(const char* linha, int* sucesso, size_t* bytes) {
+    char comando[16], nome1[MAX_FILENAME_LENGTH], nome2[MAX_FILENAME_LENGTH];
+    int campos = sscanf(linha, "%15s %254s %254s", comando, nome1, nome2);
+    if (campos < 2) return -1;
+
+    *sucesso = 0;
+    *bytes = 0;
+
+    if (strcmp(comando, "criar") == 0 && campos == 3) {
+        int elementos = atoi(nome2);
+        *bytes = (size_t)elementos * sizeof(int);
+        criar(nome1, elementos);
+        *sucesso = find(nome1) != NULL;
+        return SIM_CRIAR;
+    }
+    if (strcmp(comando, "apagar") == 0) {
+        Arquivo* arquivo = find(nome1);
+        if (arquivo) *bytes = arquivo->tamanho;
+        apagar(nome1);
+        *sucesso = arquivo != NULL && find(nome1) == NULL;
+        return SIM_APAGAR;
+    }
+    if (strcmp(comando, "concatenar") == 0 && campos == 3) {
+        Arquivo* arquivo1 = find(nome1);
+        Arquivo* arquivo2 = find(nome2);
+        size_t esperado = arquivo1 && arquivo2 ? arquivo1->tamanho + arquivo2->tamanho : 0;
+        *bytes = esperado;
+        concatenar(nome1, nome2);
+        arquivo1 = find(nome1);
+        *sucesso = esperado > 0 && arquivo1 && arquivo1->tamanho == esperado && find(nome2) == NULL;
+        return SIM_CONCATENAR;
+    }
+    if (strcmp(comando, "ordenar") == 0) {
+        Arquivo* arquivo = find(nome1);
+        if (arquivo) {
+            *bytes = arquivo->tamanho;
+            arquivo->ordenado = 0;
+        }
+        ordenar(nome1, 0);
+        arquivo = find(nome1);
+        *sucesso = arquivo != NULL && arquivo->ordenado;
+        return SIM_ORDENAR;
+    }
+
+    return -1;
+}
+
+// Enquanto a simulao roda, a sada das operaes vai para ARQUIVO_NULO
+int silenciar_saida() {
+    fflush(stdout);
+    int original = _dup(_fileno(stdout));
+    freopen(ARQUIVO_NULO, "w", stdout);
+    return original;
+}
+
+void restaurar_saida(int original) {
+    fflush(stdout);
+    _dup2(original, _fileno(stdout));
+    _close(original);
+    clearerr(stdout);
+}
+
+// Latncias de uma operao (em us), ordenadas no lugar, e o percentil pedido
+double percentil(double* latencias, size_t n, double p) {
+    if (n == 0) return 0.0;
+    size_t i = (size_t)(p * (double)(n - 1) + 0.5);
+    return latencias[i];
+}
+
+// Roda 'n' operaes geradas (trace_entrada == NULL) ou todas as linhas de trace_entrada na imagem
+// de rascunho j montada, gravando o CSV linha a linha e o resumo em JSON
+void executar_simulacao(FILE* trace_entrada, size_t n, FILE* trace_saida, FILE* csv, FILE* json) {
+    LARGE_INTEGER frequencia;
+    QueryPerformanceFrequency(&frequencia);
+
+    size_t capacidade = trace_entrada ? 1024 : n;
+    double* latencias = malloc(capacidade * sizeof(double));
+    int* operacoes_feitas = malloc(capacidade * sizeof(int));
+    if (!latencias || !operacoes_feitas) {
+        free(latencias);
+        free(operacoes_feitas);
+        fprintf(stderr, "Erro: Falha ao alocar memria\n");
+        return;
+    }
+
+    size_t total[SIM_NUM_OPERACOES] = { 0 };
+    size_t sucessos[SIM_NUM_OPERACOES] = { 0 };
+    double soma_latencia[SIM_NUM_OPERACOES] = { 0 };
+    double soma_alocacao[SIM_NUM_OPERACOES] = { 0 };
+    double fragmentacao_max = 0.0;
+    size_t executadas = 0;
+    size_t sucessos_total = 0;
+    size_t contador_nomes = 0;
+    char linha[3 * MAX_FILENAME_LENGTH];
+
+    fprintf(csv, "indice,operacao,bytes,sucesso,latencia_us,alocacao_us,arquivos,espaco_livre,"
+        "maior_extensao_livre,extensoes_livres,indice_fragmentacao,taxa_sucesso_acumulada\n");
+
+    while (trace_entrada ? fgets(linha, sizeof(linha), trace_entrada) != NULL : executadas < n) {
+        if (trace_entrada) {
+            linha[strcspn(linha, "\r\n")] = '\0';
+        }
+        else {
+            gerar_operacao(linha, sizeof(linha), &contador_nomes);
+            fprintf(trace_saida, "%s\n", linha);
+        }
+
+        int sucesso;
+        size_t bytes;
+        LARGE_INTEGER antes, depois;
+        LONGLONG alocacao_antes = ticks_alocacao;
+
+        QueryPerformanceCounter(&antes);
+        int operacao = executar_operacao_simulada(linha, &sucesso, &bytes);
+        QueryPerformanceCounter(&depois);
+        if (operacao == -1) continue;
+
+        double latencia = (double)(depois.QuadPart - antes.QuadPart) * 1e6 / (double)frequencia.QuadPart;
+        double alocacao = (double)(ticks_alocacao - alocacao_antes) * 1e6 / (double)frequencia.QuadPart;
+
+        if (executadas == capacidade) {
+            capacidade *= 2;
+            latencias = realloc(latencias, capacidade * sizeof(double));
+            operacoes_feitas = realloc(operacoes_feitas, capacidade * sizeof(int));
+        }
+        latencias[executadas] = latencia;
+        operacoes_feitas[executadas] = operacao;
+        executadas++;
+
+        total[operacao]++;
+        sucessos[operacao] += sucesso;
+        sucessos_total += sucesso;
+        soma_latencia[operacao] += latencia;
+        soma_alocacao[operacao] += alocacao;
+
+        EstadoEspaco espaco = medir_espaco();
+        double fragmentacao = indice_fragmentacao(&espaco);
+        if (fragmentacao > fragmentacao_max) fragmentacao_max = fragmentacao;
+
+        fprintf(csv, "%zu,%s,%zu,%d,%.1f,%.1f,%zu,%zu,%zu,%zu,%.4f,%.4f\n", executadas, nomes_operacoes_simulacao[operacao],
+            bytes, sucesso, latencia, alocacao, sa.quantidade_arquivos, sa.espaco_livre,
+            espaco.maior_extensao * BLOCK_SIZE, espaco.extensoes_livres, fragmentacao,
+            (double)sucessos_total / executadas);
+    }
+
+    // Resumo: percentis de latncia por operao
+    EstadoEspaco espaco = medir_espaco();
+    double* separadas = malloc((executadas > 0 ? executadas : 1) * sizeof(double));
+
+    fprintf(json, "{\n");
+    fprintf(json, "  \"operacoes\": %zu,\n", executadas);
+    fprintf(json, "  \"politica_alocacao\": \"%s\",\n", nomes_politicas[politica_alocacao]);
+    fprintf(json, "  \"tamanhos\": { \"min\": %zu, \"max\": %zu, \"distribuicao\": \"%s\" },\n",
+        config_simulacao.tamanho_min, config_simulacao.tamanho_max, config_simulacao.logaritmica ? "log" : "uniforme");
+    fprintf(json, "  \"taxa_sucesso\": %.4f,\n", executadas ? (double)sucessos_total / executadas : 0.0);
+    fprintf(json, "  \"por_operacao\": {\n");
+    for (int op = 0; op < SIM_NUM_OPERACOES; op++) {
+        size_t m = 0;
+        for (size_t i = 0; separadas && i < executadas; i++) {
+            if (operacoes_feitas[i] == op) separadas[m++] = latencias[i];
+        }
+        if (separadas) tipos[TIPO_DOUBLE].ordenar(separadas, m);
+
+        fprintf(json, "    \"%s\": { \"total\": %zu, \"sucesso\": %zu, \"taxa_sucesso\": %.4f, "
+            "\"latencia_media_us\": %.1f, \"latencia_p50_us\": %.1f, \"latencia_p99_us\": %.1f, "
+            "\"latencia_max_us\": %.1f, \"alocacao_media_us\": %.2f }%s\n",
+            nomes_operacoes_simulacao[op], total[op], sucessos[op], total[op] ? (double)sucessos[op] / total[op] : 0.0,
+            total[op] ? soma_latencia[op] / total[op] : 0.0, separadas ? percentil(separadas, m, 0.50) : 0.0,
+            separadas ? percentil(separadas, m, 0.99) : 0.0, m > 0 && separadas ? separadas[m - 1] : 0.0,
+            total[op] ? soma_alocacao[op] / total[op] : 0.0, op + 1 < SIM_NUM_OPERACOES ? "," : "");
+    }
+    fprintf(json, "  },\n");
+    fprintf(json, "  \"fragmentacao_max\": %.4f,\n", fragmentacao_max);
+    fprintf(json, "  \"final\": { \"arquivos\": %zu, \"espaco_livre\": %zu, \"maior_extensao_livre\": %zu, "
+        "\"extensoes_livres\": %zu, \"indice_fragmentacao\": %.4f }\n",
+        sa.quantidade_arquivos, sa.espaco_livre, espaco.maior_extensao * BLOCK_SIZE, espaco.extensoes_livres,
+        indice_fragmentacao(&espaco));
+    fprintf(json, "}\n");
+
+    free(separadas);
+    free(latencias);
+    free(operacoes_feitas);
+}
+
+// Monta a imagem de rascunho no lugar do disco real, roda a simulao e restaura tudo.
+// Com 'trace' NULL gera 'n' operaes a partir de 'semente' e grava o trace em <saida>.trace
+void simular(const char* trace, size_t n, unsigned int semente, const char* saida) {
+    clock_t start_time = clock();
+    char caminho[MAX_FILENAME_LENGTH + 16];
+
+    FILE* trace_entrada = NULL;
+    FILE* trace_saida = NULL;
+    if (trace) {
+        trace_entrada = fopen(trace, "r");
+        if (!trace_entrada) {
+            printf("Erro: No foi possvel abrir '%s'\n", trace);
+            return;
+        }
+    }
+    else {
+        snprintf(caminho, sizeof(caminho), "%s.trace", saida);
+        trace_saida = fopen(caminho, "w");
+    }
+    snprintf(caminho, sizeof(caminho), "%s.csv", saida);
+    FILE* csv = fopen(caminho, "w");
+    snprintf(caminho, sizeof(caminho), "%s.json", saida);
+    FILE* json = fopen(caminho, "w");
+
+    SistemaDeArquivos* sa_real = malloc(sizeof(SistemaDeArquivos));
+    if (!csv || !json || (!trace && !trace_saida) || !sa_real) {
+        printf("Erro: No foi possvel criar os arquivos de sada '%s.*'\n", saida);
+        if (trace_entrada) fclose(trace_entrada);
+        if (trace_saida) fclose(trace_saida);
+        if (csv) fclose(csv);
+        if (json) fclose(json);
+        free(sa_real);
+        return;
+    }
+
+    printf("Simulando em '%s' com alocao '%s'...\n", CAMINHO_SIMULACAO, nomes_politicas[politica_alocacao]);
+
+    // Guardar o disco real
+    salvar_estado();
+    *sa_real = sa;
+    PontoDeControle ponto_real = ponto_de_controle;
+    FILE* disco_real = disco_virtual;
+    HANDLE direto_real = disco_direto;
+    int modo_real = modo_io_direto;
+    size_t busca_real = proximo_bloco_busca;
+    size_t cache_bytes = cache.num_quadros * CACHE_PAGE_SIZE;
+
+    int saida_original = silenciar_saida();
+
+    // Montar uma imagem vazia
+    remove(CAMINHO_SIMULACAO);
+    caminho_disco = CAMINHO_SIMULACAO;
+    memset(&sa, 0, sizeof(SistemaDeArquivos));
+    memset(&ponto_de_controle, 0, sizeof(PontoDeControle));
+    proximo_bloco_busca = 0;
+    iniciar_sistema_arquivos();
+    cache_iniciar(cache_bytes);
+    abrir_disco_direto();
+
+    estado_simulacao = semente ? semente : 1;
+    srand(semente);
+    executar_simulacao(trace_entrada, n, trace_saida, csv, json);
+
+    // Desmontar e restaurar o disco real
+    fclose(disco_virtual);
+    if (disco_direto != INVALID_HANDLE_VALUE) CloseHandle(disco_direto);
+    remove(CAMINHO_SIMULACAO);
+
+    caminho_disco = "disco_virtual.bin";
+    sa = *sa_real;
+    ponto_de_controle = ponto_real;
+    disco_virtual = disco_real;
+    disco_direto = direto_real;
+    modo_io_direto = modo_real;
+    proximo_bloco_busca = busca_real;
+    cache_iniciar(cache_bytes);
+
+    restaurar_saida(saida_original);
+
+    free(sa_real);
+    if (trace_entrada) fclose(trace_entrada);
+    if (trace_saida) fclose(trace_saida);
+    fclose(csv);
+    fclose(json);
+
+    clock_t end_time = clock();
+    double duration = (double)(end_time - start_time) / CLOCKS_PER_SEC * 1000.0;
+    printf("Simulao concluda em %.2f ms. Resultados em '%s.csv' e '%s.json'\n", duration, saida, saida);
+    if (!trace) printf("Trace gerado em '%s.trace' (use reproduzir para repetir com outra poltica)\n", saida);
+}
+
+int main() {
+
+    InitializeCriticalSection(&trava_disco);
+    iniciar_sistema_arquivos();
+    cache_iniciar(CACHE_TAMANHO_PADRAO);
+    abrir_disco_direto();
+    verificar_ordenacao_interrompida();
+    allocateLargePage();
 
     char command[20];
-    char arg1[MAX_FILENAME_LENGTH], arg2[MAX_FILENAME_LENGTH];
+    char arg1[MAX_FILENAME_LENGTH], arg2[MAX_FILENAME_LENGTH], arg5[MAX_FILENAME_LENGTH];
     int arg3, arg4;
 
     printf("Mini Sistema de Arquivos\n");
     printf("Comandos disponveis:\n");
     printf("  criar nome tam\n");
+    printf("  criar_tipado nome tam tipo\n");
     printf("  apagar nome\n");
     printf("  listar\n");
     printf("  ordenar nome\n");
+    printf("  ordenar_memoria nome mb\n");
+    printf("  memoria_ordenacao mb\n");
+    printf("  interromper_apos passos\n");
+    printf("  ordenar_adaptativo nome\n");
+    printf("  ordenar_lote n nome1 ... nomen\n");
     printf("  ler nome inicio fim\n");
     printf("  concatenar nome1 nome2\n");
+    printf("  mesclar nome1 nome2 destino\n");
+    printf("  clonar origem destino\n");
+    printf("  importar arquivo_host nome\n");
+    printf("  exportar nome arquivo_host\n");
+    printf("  importar_texto arquivo_host nome\n");
+    printf("  exportar_texto nome arquivo_host\n");
+    printf("  maiores nome k\n");
+    printf("  menores nome k\n");
+    printf("  distintos nome\n");
+    printf("  distintos_valores nome destino\n");
+    printf("  cache\n");
+    printf("  cache_tamanho kb\n");
+    printf("  io_direto 0|1\n");
+    printf("  politica_alocacao primeiro|melhor|proximo\n");
+    printf("  simulacao_tamanhos min_kb max_kb uniforme|log\n");
+    printf("  simular n semente saida\n");
+    printf("  reproduzir trace saida\n");
     printf("  ajuda\n");
     printf("  sair\n");
 
@@ -901,6 +4082,16 @@ int main() {
             scanf("%s %d", arg1, &arg3);
             criar(arg1, arg3);
         }
+        else if (strcmp(command, "criar_tipado") == 0) {
+            scanf("%s %d %s", arg1, &arg3, arg2);
+            int tipo = tipo_por_nome(arg2);
+            if (tipo == -1) {
+                printf("Erro: Tipo '%s' desconhecido (int32, int64, uint32, float, double, chave_valor)\n", arg2);
+            }
+            else {
+                criar_tipado(arg1, arg3, tipo);
+            }
+        }
         else if (strcmp(command, "apagar") == 0) {
             scanf("%s", arg1);
             apagar(arg1);
@@ -910,7 +4101,20 @@ int main() {
         }
         else if (strcmp(command, "ordenar") == 0) {
             scanf("%s", arg1);
-            ordenar(arg1);
+            ordenar(arg1, 0);
+        }
+        else if (strcmp(command, "ordenar_lote") == 0) {
+            scanf("%d", &arg3);
+            char (*nomes)[MAX_FILENAME_LENGTH] = malloc((arg3 > 0 ? arg3 : 1) * sizeof(*nomes));
+            if (!nomes) {
+                printf("Erro: Falha ao alocar memria\n");
+                continue;
+            }
+            for (int i = 0; i < arg3; i++) {
+                scanf("%s", nomes[i]);
+            }
+            ordenar_lote(arg3, nomes);
+            free(nomes);
         }
         else if (strcmp(command, "ler") == 0) {
             scanf("%s %d %d", arg1, &arg3, &arg4);
@@ -920,15 +4124,150 @@ int main() {
             scanf("%s %s", arg1, arg2);
             concatenar(arg1, arg2);
         }
+        else if (strcmp(command, "mesclar") == 0) {
+            scanf("%s %s %s", arg1, arg2, arg5);
+            mesclar(arg1, arg2, arg5);
+        }
+        else if (strcmp(command, "maiores") == 0) {
+            scanf("%s %d", arg1, &arg3);
+            top_k(arg1, arg3, 1);
+        }
+        else if (strcmp(command, "menores") == 0) {
+            scanf("%s %d", arg1, &arg3);
+            top_k(arg1, arg3, 0);
+        }
+        else if (strcmp(command, "distintos") == 0) {
+            scanf("%s", arg1);
+            distintos(arg1);
+        }
+        else if (strcmp(command, "distintos_valores") == 0) {
+            scanf("%s %s", arg1, arg2);
+            distintos_valores(arg1, arg2);
+        }
+        else if (strcmp(command, "cache") == 0) {
+            estatisticas_cache();
+        }
+        else if (strcmp(command, "cache_tamanho") == 0) {
+            scanf("%d", &arg3);
+            cache_iniciar(arg3 > 0 ? (size_t)arg3 * 1024 : 0);
+            estatisticas_cache();
+        }
+        else if (strcmp(command, "simular") == 0) {
+            scanf("%d %d %s", &arg3, &arg4, arg1);
+            if (arg3 <= 0) {
+                printf("Erro: O nmero de operaes deve ser positivo\n");
+            }
+            else {
+                simular(NULL, arg3, arg4, arg1);
+            }
+        }
+        else if (strcmp(command, "reproduzir") == 0) {
+            scanf("%s %s", arg1, arg2);
+            simular(arg1, 0, 0, arg2);
+        }
+        else if (strcmp(command, "simulacao_tamanhos") == 0) {
+            scanf("%d %d %s", &arg3, &arg4, arg1);
+            if (arg3 <= 0 || arg4 < arg3 || (strcmp(arg1, "uniforme") != 0 && strcmp(arg1, "log") != 0)) {
+                printf("Erro: Use simulacao_tamanhos min_kb max_kb uniforme|log\n");
+            }
+            else {
+                config_simulacao.tamanho_min = (size_t)arg3 * 1024;
+                config_simulacao.tamanho_max = (size_t)arg4 * 1024;
+                config_simulacao.logaritmica = strcmp(arg1, "log") == 0;
+                printf("Tamanhos da simulao: %d KB a %d KB (%s)\n", arg3, arg4, arg1);
+            }
+        }
+        else if (strcmp(command, "politica_alocacao") == 0) {
+            scanf("%s", arg1);
+            int encontrada = 0;
+            for (int p = 0; p < 3; p++) {
+                if (strcmp(arg1, nomes_politicas[p]) == 0) {
+                    politica_alocacao = p;
+                    encontrada = 1;
+                }
+            }
+            if (encontrada) printf("Poltica de alocao: %s\n", arg1);
+            else printf("Erro: Poltica '%s' desconhecida (primeiro, melhor, proximo)\n", arg1);
+        }
+        else if (strcmp(command, "io_direto") == 0) {
+            scanf("%d", &arg3);
+            modo_io_direto = arg3 != 0 && disco_direto != INVALID_HANDLE_VALUE;
+            printf("E/S direta %s\n", modo_io_direto ? "ativada" : "desativada");
+        }
+        else if (strcmp(command, "ordenar_adaptativo") == 0) {
+            scanf("%s", arg1);
+            ordenar_adaptativo(arg1);
+        }
+        else if (strcmp(command, "ordenar_memoria") == 0) {
+            scanf("%s %d", arg1, &arg3);
+            ordenar(arg1, arg3 > 0 ? (size_t)arg3 * 1024 * 1024 : 0);
+        }
+        else if (strcmp(command, "memoria_ordenacao") == 0) {
+            scanf("%d", &arg3);
+            orcamento_ordenacao_padrao = arg3 > 0 ? (size_t)arg3 * 1024 * 1024 : 0;
+            if (orcamento_ordenacao_padrao == 0) {
+                printf("Memria de ordenao automtica: %zu MB\n", orcamento_automatico() / (1024 * 1024));
+            }
+            else {
+                printf("Memria de ordenao: %zu MB\n", orcamento_ordenacao_padrao / (1024 * 1024));
+            }
+        }
+        else if (strcmp(command, "interromper_apos") == 0) {
+            scanf("%d", &arg3);
+            interromper_apos_passos = arg3 > 0 ? (size_t)arg3 : 0;
+        }
+        else if (strcmp(command, "clonar") == 0) {
+            scanf("%s %s", arg1, arg2);
+            clonar(arg1, arg2);
+        }
+        else if (strcmp(command, "importar") == 0) {
+            scanf("%s %s", arg1, arg2);
+            importar(arg1, arg2);
+        }
+        else if (strcmp(command, "exportar") == 0) {
+            scanf("%s %s", arg1, arg2);
+            exportar(arg1, arg2);
+        }
+        else if (strcmp(command, "importar_texto") == 0) {
+            scanf("%s %s", arg1, arg2);
+            importar_texto(arg1, arg2);
+        }
+        else if (strcmp(command, "exportar_texto") == 0) {
+            scanf("%s %s", arg1, arg2);
+            exportar_texto(arg1, arg2);
+        }
         else if (strcmp(command, "ajuda") == 0) {
             printf("Mini Sistema de Arquivos\n");
             printf("Comandos disponveis:\n");
             printf("  criar nome tam\n");
+            printf("  criar_tipado nome tam tipo\n");
             printf("  apagar nome\n");
             printf("  listar\n");
             printf("  ordenar nome\n");
+            printf("  ordenar_memoria nome mb\n");
+            printf("  memoria_ordenacao mb\n");
+            printf("  interromper_apos passos\n");
+            printf("  ordenar_adaptativo nome\n");
+            printf("  ordenar_lote n nome1 ... nomen\n");
             printf("  ler nome inicio fim\n");
             printf("  concatenar nome1 nome2\n");
+            printf("  mesclar nome1 nome2 destino\n");
+            printf("  clonar origem destino\n");
+            printf("  importar arquivo_host nome\n");
+            printf("  exportar nome arquivo_host\n");
+            printf("  importar_texto arquivo_host nome\n");
+            printf("  exportar_texto nome arquivo_host\n");
+            printf("  maiores nome k\n");
+            printf("  menores nome k\n");
+            printf("  distintos nome\n");
+            printf("  distintos_valores nome destino\n");
+            printf("  cache\n");
+            printf("  cache_tamanho kb\n");
+            printf("  io_direto 0|1\n");
+            printf("  politica_alocacao primeiro|melhor|proximo\n");
+            printf("  simulacao_tamanhos min_kb max_kb uniforme|log\n");
+            printf("  simular n semente saida\n");
+            printf("  reproduzir trace saida\n");
             printf("  ajuda\n");
             printf("  sair\n");
         }
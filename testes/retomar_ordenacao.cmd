@@ -0,0 +1,35 @@
+@echo off
+rem Interrompe uma ordenao externa no meio ('interromper_apos') e confere que a execuo seguinte
+rem continua de onde parou e chega ao mesmo resultado que uma ordenao sem interrupo.
+rem Uso: testes\retomar_ordenacao.cmd caminho\do\OSTrab02-Main.exe
+setlocal
+if "%~1"=="" (
+    echo Uso: %~nx0 caminho\do\OSTrab02-Main.exe
+    exit /b 2
+)
+set PROGRAMA=%~f1
+set PASTA=%TEMP%\retomar_ordenacao
+if exist "%PASTA%" rmdir /s /q "%PASTA%"
+mkdir "%PASTA%"
+pushd "%PASTA%"
+
+rem 1. 'y'  um clone de 'x'; com 2 MB de memria a ordenao de 'x'  externa e termina o processo aps 10 passos
+(echo criar x 4000000& echo clonar x y& echo memoria_ordenacao 2& echo interromper_apos 10& echo ordenar x& echo sair) | "%PROGRAMA%" > execucao1.txt
+findstr /c:"Processo interrompido" execucao1.txt > nul || (echo FALHOU: a ordenacao de 'x' nao foi interrompida& goto falha)
+
+rem 2. A ordenao externa de 'y' no pode recriar o pagefile de 'x'; 'x' continua e depois 'y'  ordenado do zero
+(echo memoria_ordenacao 2& echo ordenar y& echo ordenar x& echo ordenar y& echo exportar x x.bin& echo exportar y y.bin& echo sair) | "%PROGRAMA%" > execucao2.txt
+findstr /c:"foi interrompida" execucao2.txt > nul || (echo FALHOU: a interrupcao nao foi detectada na inicializacao& goto falha)
+findstr /c:"usa o pagefile" execucao2.txt > nul || (echo FALHOU: a ordenacao de 'y' substituiu o ponto de controle de 'x'& goto falha)
+findstr /c:"Continuando a ordena" execucao2.txt > nul || (echo FALHOU: a ordenacao de 'x' recomecou do zero& goto falha)
+fc /b x.bin y.bin > nul || (echo FALHOU: 'x' difere da ordenacao sem interrupcao& goto falha)
+
+popd
+rmdir /s /q "%PASTA%"
+echo OK
+exit /b 0
+
+:falha
+echo Saidas em %PASTA%
+popd
+exit /b 1